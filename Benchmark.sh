@@ -0,0 +1,37 @@
+#!/bin/bash
+
+# Exit immediately if any command fails
+set -e
+
+cd "$(dirname "$0")"
+
+if [ $# -lt 1 ]; then
+  echo "Usage: $0 <benchmark>" >&2
+  echo "Available benchmarks:" >&2
+  for f in cpp/bench/*_bench.cpp; do
+    name=$(basename "$f" _bench.cpp)
+    echo "  $name" >&2
+  done
+  exit 1
+fi
+
+bench_name="$1"
+shift
+bench_source="bench/${bench_name}_bench.cpp"
+
+cd cpp || { echo "Error entering cpp directory" >&2; exit 1; }
+
+if [ ! -f "$bench_source" ]; then
+    echo "Error: benchmark '$bench_name' not found ($bench_source)." >&2
+    exit 1
+fi
+
+# Compile
+g++ -std=c++14 -O2 -pthread -Iinclude "$bench_source" src/*.cpp -o benchmark || {
+    echo "Compilation failed. Aborting." >&2
+    exit 1
+}
+
+./benchmark "$@"
+
+rm benchmark || { echo "Warning: could not remove benchmark binary" >&2; }
@@ -45,36 +45,19 @@ if [ -z "$max_scale" ]; then
     exit 1
 fi
 
-if (( $(echo "$min_scale > $max_scale" | bc -l) )); then 
-    echo "Error: minimum scale must be smaller than maximum scale" >&2
-    exit 1
-fi
-
-output_dir="$(pwd)/out/$run_name/data"
-mkdir -p "$output_dir" || { echo "Error creating output directory $output_dir" >&2; exit 1; }
-
 cd cpp || { echo "Error entering cpp directory" >&2; exit 1; }
 
-output_file="$output_dir/simulations_output.txt"
-echo "Scale Absorbed std Reflected std Scaped std" > "$output_file" || { echo "Error creating output file" >&2; exit 1; }
-
 # Compile
-g++ -std=c++14 -Iinclude main.cpp src/*.cpp -o simulation || {
+g++ -std=c++14 -O2 -pthread -Iinclude main.cpp src/*.cpp -o simulation || {
     echo "Compilation failed. Aborting." >&2
     exit 1 
 }
 
-# Run simulations
-iterations=20
-for ((i=0; i<=$iterations; i++)); do
-    
-    L=$(echo "$min_scale + ($max_scale - $min_scale) * $i / $iterations" | bc -l)
-
-    L=$(echo "scale=2; $L/1" | bc -l)
-    
-    output=$(./simulation "../$json_file" $L)
-    echo "$L $output" >> "$output_file" || { echo "Error writing to output file" >&2; exit 1; }
-done
+# Run simulations: all geometry sizes in one process, with common random numbers.
+# The simulation checks the scales and writes out/<run_name>/data/simulations_output.txt
+points=21
+threads=$(nproc 2>/dev/null || sysctl -n hw.ncpu 2>/dev/null || echo 1)
+./simulation "../$json_file" --sweep "$min_scale" "$max_scale" $points --threads "$threads" > /dev/null
 
 rm simulation || { echo "Warning: could not remove simulation binary" >&2; }
 
@@ -53,7 +53,7 @@ output_file="$output_dir/simulations_output.txt"
 echo "Scale Absorbed std Reflected std Scaped std" > "$output_file" || { echo "Error creating output file" >&2; exit 1; }
 
 # Compile
-g++ -std=c++14 -Iinclude main.cpp src/*.cpp -o simulation || {
+g++ -std=c++14 -O2 -pthread -Iinclude main.cpp src/*.cpp -o simulation || {
     echo "Compilation failed. Aborting." >&2
     exit 1 
 }
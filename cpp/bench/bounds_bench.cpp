@@ -0,0 +1,90 @@
+// Microbenchmark of the bounds checks of the geometries.
+//
+// Checks a bank of random positions around each shape against it: one
+// virtual isWithinBounds per particle (the analog loop), contains() per position, and
+// the batch containsBatch() with each instruction set the machine has.
+#include "regularslab.hpp"
+#include "finiteslab.hpp"
+#include "sphere.hpp"
+#include "doubleslab.hpp"
+#include "neutron.hpp"
+#include "rngengines.hpp"
+#include "simd.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace {
+
+const int kLanes = 1024;
+
+volatile long sink;
+
+// Runs f (which checks kLanes positions and returns the count inside) until n checks
+// are done and prints the throughput in checks per nanosecond
+template <typename F>
+void measure(const char* name, long n, F f) {
+    long acc = 0;
+    const long repeats = n / kLanes;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < repeats; ++i) acc += f();
+    auto stop = std::chrono::steady_clock::now();
+    sink = acc;
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    double checks = static_cast<double>(repeats) * kLanes;
+    std::printf("%-28s %10.4f checks/ns %8.3f ns/check  (%.1f%% inside)\n", name, checks / ns, ns / checks,
+                100.0 * acc / checks);
+}
+
+template <typename Geometry>
+void measureShape(const char* label, const Geometry& geometry, double span, long n) {
+    BasicRandomGenerator<PhiloxEngine> rng(12345);
+    std::vector<double> x(kLanes), y(kLanes), z(kLanes);
+    std::vector<std::uint8_t> inside(kLanes);
+    std::vector<std::unique_ptr<Particle>> particles;
+    for (int i = 0; i < kLanes; ++i) {
+        x[i] = span * (2.0 * rng.uniform() - 1.0);
+        y[i] = span * (2.0 * rng.uniform() - 1.0);
+        z[i] = span * (2.0 * rng.uniform() - 1.0);
+        particles.emplace_back(new Neutron(x[i], y[i], z[i], 0.0, 0.0, 0.0));
+    }
+    const BaseMaterial& material = geometry;
+
+    std::printf("-- %s\n", label);
+    measure("isWithinBounds (virtual)", n, [&] {
+        long count = 0;
+        for (int i = 0; i < kLanes; ++i) count += material.isWithinBounds(*particles[i]);
+        return count;
+    });
+    measure("contains", n, [&] {
+        long count = 0;
+        for (int i = 0; i < kLanes; ++i) count += geometry.contains(x[i], y[i], z[i]);
+        return count;
+    });
+    for (int level = 0; level <= static_cast<int>(maxSimdLevel()); ++level) {
+        setSimdLevel(static_cast<SimdLevel>(level));
+        char name[64];
+        std::snprintf(name, sizeof(name), "containsBatch (%s)", simdLevelName(simdLevel()));
+        measure(name, n, [&] {
+            geometry.containsBatch(x.data(), y.data(), z.data(), inside.data(), kLanes);
+            long count = 0;
+            for (int i = 0; i < kLanes; ++i) count += inside[i];
+            return count;
+        });
+    }
+    setSimdLevel(maxSimdLevel());
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    const long n = argc > 1 ? std::atol(argv[1]) : 200000000L;
+
+    measureShape("regular slab", RegularSlab(1.0, 0.1, 0.0, 1.0, 0.0), 1.0, n);
+    measureShape("finite slab", FiniteSlab(1.0, 0.1, 0.0, 1.2, 1.2, 1.2), 1.0, n);
+    measureShape("sphere", Sphere(1.0, 0.1, 0.0, 1.0), 1.25, n);
+    measureShape("double slab", DoubleSlab(1.0, 0.1, 0.0, 2.0, 0.2, 0.0, 1.0, 0.0, 0.5), 1.0, n);
+    return 0;
+}
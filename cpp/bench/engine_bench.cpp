@@ -0,0 +1,85 @@
+// Benchmark of the random engines behind RandomGenerator on a real configuration.
+//
+// Runs the full transport (all replicas) once per engine and geometry size and reports
+// histories per second together with the resulting fractions, so the engine can be
+// chosen by measurement on each machine.
+//
+// Usage: engine_bench [config.json]   (default ../config.json)
+#include "materialfactory.hpp"
+#include "transport.hpp"
+#include "rngengines.hpp"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+
+namespace {
+
+double mean(const std::vector<double>& values) {
+    return std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+}
+
+template <typename Engine>
+void benchmark(const TransportSettings& settings, const BaseMaterial& material, double scale) {
+    auto start = std::chrono::steady_clock::now();
+    TransportResult result = runTransport<Engine>(settings, material);
+    auto stop = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    double histories = static_cast<double>(settings.numberSims) * settings.replicas;
+    std::printf("%-14s %8.2f %14.0f %10.5f %10.5f %10.5f\n", Engine::name(), scale, histories / seconds,
+                mean(result.absorbedRatios), mean(result.reflectedRatios), mean(result.scapedRatios));
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::string path = argc > 1 ? argv[1] : "../config.json";
+    std::ifstream config_file(path);
+    if (!config_file) {
+        std::cerr << "Error: Could not open config file " << path << "\n";
+        return 1;
+    }
+
+    json config;
+    try {
+        config_file >> config;
+    } catch (const json::parse_error& e) {
+        std::cerr << "Error parsing JSON file: " << e.what() << "\n";
+        return 1;
+    }
+
+    ConfigError config_error;
+    MaterialFactory configuration;
+    configuration.validate_config(config, config_error);
+    if (config_error.has_errors()) {
+        config_error.print_errors();
+        return 1;
+    }
+
+    TransportSettings settings = TransportSettings::fromConfig(config);
+    settings.saveHistories = false;
+
+    // Shipped configurations either fix one scale or give the range of a sweep
+    std::vector<double> scales;
+    if (config["geometry"].contains("scale")) {
+        scales.push_back(config["geometry"]["scale"]);
+    } else {
+        scales.push_back(config["geometry"]["min_scale"]);
+        scales.push_back(config["geometry"]["max_scale"]);
+    }
+
+    std::printf("%-14s %8s %14s %10s %10s %10s\n", "engine", "scale", "histories/s", "absorbed", "reflected", "scaped");
+    for (double scale : scales) {
+        std::unique_ptr<BaseMaterial> material =
+            configuration.createMaterial(config, settings.shape, scale, settings.particleType == "charged");
+
+        benchmark<PhiloxEngine>(settings, *material, scale);
+        benchmark<Xoshiro256ppEngine>(settings, *material, scale);
+        benchmark<Pcg64Engine>(settings, *material, scale);
+        benchmark<Mt19937_64Engine>(settings, *material, scale);
+    }
+
+    return 0;
+}
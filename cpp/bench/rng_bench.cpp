@@ -0,0 +1,83 @@
+// Microbenchmark of the random sampling used by the transport loop.
+//
+// Compares the former per-draw std::random_device + std::mt19937 path with the
+// batched Philox buffers of RandomGenerator, with and without the AVX2 kernel.
+#include "rngengines.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace {
+
+volatile double sink;
+
+// Runs f n times and prints the throughput in samples per nanosecond
+template <typename F>
+void measure(const char* name, long n, F f) {
+    double acc = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < n; ++i) acc += f();
+    auto stop = std::chrono::steady_clock::now();
+    sink = acc;
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    std::printf("%-34s %12.4f samples/ns %10.2f ns/sample\n", name, n / ns, ns / n);
+}
+
+double legacyUniform() {
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_real_distribution<> distrib(0, 1);
+    return distrib(gen);
+}
+
+double legacyExponential() {
+    return -std::log(legacyUniform());
+}
+
+double legacyDirection() {
+    double phi = legacyUniform() * 2 * M_PI;
+    double theta = std::acos(2 * legacyUniform() - 1);
+    return std::cos(phi) * std::sin(theta) + std::sin(phi) * std::sin(theta) + std::cos(theta);
+}
+
+void measureGenerator(const char* label, long n) {
+    BasicRandomGenerator<PhiloxEngine> rng(12345);
+    std::printf("-- RandomGenerator (%s)\n", label);
+    measure("uniform", n, [&] { return rng.uniform(); });
+    measure("exponential (-log(1 - u))", n, [&] { return -std::log(1.0 - rng.uniform()); });
+    measure("exponential (ziggurat)", n, [&] { return rng.exponential(); });
+    measure("isotropicDirection", n, [&] {
+        std::array<double, 3> u = rng.isotropicDirection();
+        return u[0] + u[1] + u[2];
+    });
+}
+
+}
+
+int main() {
+    const long nLegacy = 200000;
+    const long n = 50000000;
+
+    std::printf("-- per-draw std::random_device + std::mt19937\n");
+    measure("uniform", nLegacy, legacyUniform);
+    measure("exponential", nLegacy, legacyExponential);
+    measure("spherical angles + trig", nLegacy / 2, legacyDirection);
+
+    std::mt19937 gen(12345);
+    std::uniform_real_distribution<> distrib(0, 1);
+    std::printf("-- persistent std::mt19937\n");
+    measure("uniform", n, [&] { return distrib(gen); });
+
+    bool simd = Philox4x32::simdAvailable();
+    Philox4x32::setSimdEnabled(false);
+    measureGenerator("scalar Philox", n);
+    if (simd) {
+        Philox4x32::setSimdEnabled(true);
+        measureGenerator("AVX2 Philox", n);
+    } else {
+        std::printf("-- AVX2 kernel not available on this machine\n");
+    }
+
+    return 0;
+}
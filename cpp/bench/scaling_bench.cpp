@@ -0,0 +1,144 @@
+// Thread-scaling benchmark of the transport loop on a fixed workload.
+//
+// Runs every geometry of MaterialFactory::createMaterial with a neutron and a charged
+// particle at 1, 2, 4, ... threads up to the given maximum, and reports for each run
+// the throughput, the parallel efficiency against one thread and the imbalance between
+// the busy times of the threads (max / mean - 1). The table is printed and written to
+// <prefix>.json and <prefix>.csv, to size node allocations and to catch scaling
+// regressions when the transport loop changes.
+//
+// Usage: scaling_bench [max_threads] [simulations] [prefix]
+//        (defaults: all cores, 20000 histories per replica, "scaling")
+#include "materialfactory.hpp"
+#include "transport.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace {
+
+const int kReplicas = 10;
+
+// Same material and geometry for every run; each shape reads the fields it needs
+json workload(const std::string& shape, const std::string& type, int simulations) {
+    json config = {
+        {"run", {{"run_name", "scaling_bench"}, {"simulations", simulations}, {"replicas", kReplicas}, {"seed", 12345}}},
+        {"particle", {{"type", type}, {"x", 0}, {"y", 0}, {"z", 0}, {"vx", 0.5}, {"vy", 0}, {"vz", 0},
+                      {"charge", 1.0}, {"mass", 1.0}}},
+        {"material", {{"mean_free_path", 0.5}, {"pabs", 0.1}, {"k", 0.01}, {"absorption_power", 0.01},
+                      {"mean_free_path1", 0.5}, {"pabs1", 0.1}, {"k1", 0.01}, {"absorption_power1", 0.01},
+                      {"mean_free_path2", 0.25}, {"pabs2", 0.05}, {"k2", 0.01}, {"absorption_power2", 0.01}}},
+        {"geometry", {{"shape", shape}, {"x_init", 0}, {"x_length", 5}, {"y_length", 5}, {"total_length", 5}}}
+    };
+    return config;
+}
+
+struct Measurement {
+    std::string shape;
+    std::string particle;
+    int threads;
+    double seconds;
+    double historiesPerSecond;
+    double efficiency;
+    double imbalance;
+};
+
+Measurement measure(const json& config, int threads) {
+    TransportSettings settings = TransportSettings::fromConfig(config);
+    settings.saveHistories = false;
+    settings.threads = threads;
+
+    std::unique_ptr<BaseMaterial> material =
+        MaterialFactory::createMaterial(config, settings.shape, 2.5, settings.particleType == "charged");
+
+    auto start = std::chrono::steady_clock::now();
+    TransportResult result = runTransport(settings, *material);
+    auto stop = std::chrono::steady_clock::now();
+
+    double busyMax = 0.0;
+    double busySum = 0.0;
+    for (const WorkerStats& worker : result.workerStats) {
+        busyMax = std::max(busyMax, worker.busySeconds);
+        busySum += worker.busySeconds;
+    }
+    const double busyMean = busySum / result.workerStats.size();
+
+    Measurement m;
+    m.shape = settings.shape;
+    m.particle = settings.particleType;
+    m.threads = threads;
+    m.seconds = std::chrono::duration<double>(stop - start).count();
+    m.historiesPerSecond = static_cast<double>(settings.numberSims) * settings.replicas / m.seconds;
+    m.efficiency = 1.0;
+    m.imbalance = busyMean > 0.0 ? busyMax / busyMean - 1.0 : 0.0;
+    return m;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    int maxThreads = argc > 1 ? std::atoi(argv[1]) : static_cast<int>(std::thread::hardware_concurrency());
+    int simulations = argc > 2 ? std::atoi(argv[2]) : 20000;
+    std::string prefix = argc > 3 ? argv[3] : "scaling";
+    if (maxThreads < 1 || simulations < 1) {
+        std::cerr << "Usage: " << argv[0] << " [max_threads] [simulations] [prefix]\n";
+        return 1;
+    }
+
+    // Powers of two, then the maximum itself
+    std::vector<int> threadCounts;
+    for (int t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+
+    const char* shapes[] = {"regular_slab", "finite_slab", "sphere", "double_slab"};
+    const char* particles[] = {"neutron", "charged"};
+
+    std::vector<Measurement> measurements;
+    std::printf("%-14s %-8s %8s %10s %14s %11s %10s\n", "shape", "particle", "threads", "seconds", "histories/s",
+                "efficiency", "imbalance");
+    for (const char* shape : shapes) {
+        for (const char* particle : particles) {
+            json config = workload(shape, particle, simulations);
+            double baseline = 0.0;
+            for (int threads : threadCounts) {
+                Measurement m = measure(config, threads);
+                if (threads == 1) baseline = m.historiesPerSecond;
+                m.efficiency = m.historiesPerSecond / (baseline * threads);
+                std::printf("%-14s %-8s %8d %10.3f %14.0f %10.1f%% %9.1f%%\n", m.shape.c_str(), m.particle.c_str(),
+                            m.threads, m.seconds, m.historiesPerSecond, 100.0 * m.efficiency, 100.0 * m.imbalance);
+                std::fflush(stdout);
+                measurements.push_back(m);
+            }
+        }
+    }
+
+    json report = {{"simulations", simulations}, {"replicas", kReplicas}, {"hardware_threads", std::thread::hardware_concurrency()},
+                   {"runs", json::array()}};
+    std::ofstream csv(prefix + ".csv");
+    csv << "shape,particle,threads,seconds,histories_per_second,efficiency,imbalance\n";
+    for (const Measurement& m : measurements) {
+        report["runs"].push_back({{"shape", m.shape}, {"particle", m.particle}, {"threads", m.threads},
+                                  {"seconds", m.seconds}, {"histories_per_second", m.historiesPerSecond},
+                                  {"efficiency", m.efficiency}, {"imbalance", m.imbalance}});
+        csv << m.shape << "," << m.particle << "," << m.threads << "," << m.seconds << ","
+            << m.historiesPerSecond << "," << m.efficiency << "," << m.imbalance << "\n";
+    }
+    std::ofstream out(prefix + ".json");
+    out << report.dump(2) << "\n";
+
+    if (!out) {
+        std::cerr << "Error: Could not write " << prefix << ".json\n";
+        return 1;
+    }
+    if (!csv) {
+        std::cerr << "Error: Could not write " << prefix << ".csv\n";
+        return 1;
+    }
+    std::cout << "Wrote " << prefix << ".json and " << prefix << ".csv\n";
+    return 0;
+}
@@ -0,0 +1,104 @@
+// Microbenchmark of elastic scattering.
+//
+// Scatters a bank of collisions one at a time (the per-particle path of the analog loop)
+// and in batches with each instruction set the machine has, and checks that every batch
+// gives the velocities of the one-at-a-time path bit for bit.
+#include "elasticscatter.hpp"
+#include "rngengines.hpp"
+#include "simd.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const int kLanes = 1024;
+
+volatile double sink;
+
+struct Collisions {
+    std::vector<double> vx, vy, vz, ux, uy, uz, atomicMass;
+};
+
+Collisions sample() {
+    BasicRandomGenerator<PhiloxEngine> rng(12345);
+    Collisions c;
+    for (int i = 0; i < kLanes; ++i) {
+        const std::array<double, 3> v = rng.isotropicDirection();
+        const std::array<double, 3> u = rng.isotropicDirection();
+        const double speed = 0.1 + rng.uniform();
+        c.vx.push_back(speed * v[0]);
+        c.vy.push_back(speed * v[1]);
+        c.vz.push_back(speed * v[2]);
+        c.ux.push_back(u[0]);
+        c.uy.push_back(u[1]);
+        c.uz.push_back(u[2]);
+        c.atomicMass.push_back(1.0 + 200.0 * rng.uniform());
+    }
+    return c;
+}
+
+// Runs f (which scatters the kLanes collisions of c) until n collisions are done and
+// prints the throughput in collisions per nanosecond
+template <typename F>
+void measure(const char* name, long n, Collisions c, F f) {
+    const long repeats = n / kLanes;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < repeats; ++i) f(c);
+    auto stop = std::chrono::steady_clock::now();
+    sink = c.vx[0] + c.vy[kLanes - 1];
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    double collisions = static_cast<double>(repeats) * kLanes;
+    std::printf("%-28s %10.4f collisions/ns %8.3f ns/collision\n", name, collisions / ns, ns / collisions);
+}
+
+void one(double mass, Collisions& c) {
+    for (int i = 0; i < kLanes; ++i) {
+        std::array<double, 3> v = {c.vx[i], c.vy[i], c.vz[i]};
+        ElasticScatter::apply(mass, c.atomicMass[i], v, {c.ux[i], c.uy[i], c.uz[i]});
+        c.vx[i] = v[0];
+        c.vy[i] = v[1];
+        c.vz[i] = v[2];
+    }
+}
+
+void batch(double mass, Collisions& c) {
+    ElasticScatter::apply(mass, c.atomicMass.data(), c.vx.data(), c.vy.data(), c.vz.data(),
+                          c.ux.data(), c.uy.data(), c.uz.data(), kLanes);
+}
+
+bool same(const std::vector<double>& a, const std::vector<double>& b) {
+    return std::memcmp(a.data(), b.data(), a.size() * sizeof(double)) == 0;
+}
+
+void measureParticle(const char* label, double mass, long n) {
+    const Collisions collisions = sample();
+    Collisions reference = collisions;
+    one(mass, reference);
+
+    std::printf("-- %s (mass %g)\n", label, mass);
+    measure("one at a time", n, collisions, [&](Collisions& c) { one(mass, c); });
+    for (int level = 0; level <= static_cast<int>(maxSimdLevel()); ++level) {
+        setSimdLevel(static_cast<SimdLevel>(level));
+        Collisions check = collisions;
+        batch(mass, check);
+        const bool identical = same(check.vx, reference.vx) && same(check.vy, reference.vy) &&
+                               same(check.vz, reference.vz);
+        char name[64];
+        std::snprintf(name, sizeof(name), "batch (%s)%s", simdLevelName(simdLevel()), identical ? "" : " DIFFERS");
+        measure(name, n, collisions, [&](Collisions& c) { batch(mass, c); });
+    }
+    setSimdLevel(maxSimdLevel());
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    const long n = argc > 1 ? std::atol(argv[1]) : 100000000L;
+
+    measureParticle("neutron", 1.0, n);
+    measureParticle("charged", 4.0, n);
+    return 0;
+}
@@ -0,0 +1,29 @@
+#ifndef BOUNDSCHECK_HPP
+#define BOUNDSCHECK_HPP
+
+#include <array>
+#include <cstdint>
+
+/**
+ * @brief Batch bounds checks on positions stored as structure of arrays.
+ *
+ * Each check tests n positions (x[i], y[i], z[i]) against one shape and writes
+ * inside[i] = 1 or 0. The shapes cover every geometry: an interval of x (regular and
+ * double slab), an axis-aligned box (finite slab) and a ball around the origin
+ * (sphere). Kernels use AVX-512 or AVX2 at the selected simdLevel(), four or eight
+ * positions per instruction, and a scalar loop otherwise; all give the same answer as
+ * the contains() of the geometry, position by position.
+ */
+struct BoundsCheck {
+    /// x in [lo, hi]
+    static void interval(const double* x, double lo, double hi, std::uint8_t* inside, int n);
+
+    /// Every coordinate within [lo, hi] of its axis
+    static void box(const double* x, const double* y, const double* z,
+                    const std::array<double, 3>& lo, const std::array<double, 3>& hi, std::uint8_t* inside, int n);
+
+    /// sqrt(x^2 + y^2 + z^2) <= radius
+    static void ball(const double* x, const double* y, const double* z, double radius, std::uint8_t* inside, int n);
+};
+
+#endif // BOUNDSCHECK_HPP
@@ -0,0 +1,48 @@
+#ifndef CACHEALIGNED_HPP
+#define CACHEALIGNED_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+/// Size of a cache line on the targeted x86-64 and ARM64 machines
+const std::size_t kCacheLineSize = 64;
+
+/**
+ * @brief Allocator whose blocks start on a cache line.
+ *
+ * std::allocator only guarantees the alignment of std::max_align_t before C++17, so a
+ * vector of alignas(kCacheLineSize) elements could still start halfway into a line
+ * shared with another thread's data. The block is over-allocated and the original
+ * pointer stored just before the aligned start.
+ *
+ * @tparam T Element type
+ */
+template <typename T>
+struct CacheAlignedAllocator {
+    typedef T value_type;
+
+    CacheAlignedAllocator() = default;
+    template <typename U>
+    CacheAlignedAllocator(const CacheAlignedAllocator<U>&) {}
+
+    T* allocate(std::size_t n) {
+        char* block = static_cast<char*>(::operator new(n * sizeof(T) + kCacheLineSize + sizeof(void*)));
+        const std::uintptr_t start = reinterpret_cast<std::uintptr_t>(block + sizeof(void*));
+        char* aligned = reinterpret_cast<char*>((start + kCacheLineSize - 1) & ~(kCacheLineSize - 1));
+        reinterpret_cast<void**>(aligned)[-1] = block;
+        return reinterpret_cast<T*>(aligned);
+    }
+
+    void deallocate(T* p, std::size_t) {
+        ::operator delete(reinterpret_cast<void**>(p)[-1]);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const CacheAlignedAllocator<T>&, const CacheAlignedAllocator<U>&) { return true; }
+
+template <typename T, typename U>
+bool operator!=(const CacheAlignedAllocator<T>&, const CacheAlignedAllocator<U>&) { return false; }
+
+#endif // CACHEALIGNED_HPP
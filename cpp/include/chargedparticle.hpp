@@ -34,8 +34,9 @@ public:
      * Implements step-by-step propagation, applying energy loss, scattering, etc.
      * 
      * @param material Reference to the material the particle is moving through
+     * @param rng Random number context of the current worker
      */
-    void propagate(const BaseMaterial& material) override;
+    void propagate(const BaseMaterial& material, RandomGenerator& rng) override;
 
     /**
      * @brief Apply continuous energy loss according to the material’s stopping power.
@@ -45,7 +46,7 @@ public:
      */
     void applyEnergyLoss(const BaseMaterial& material, double stepLength);
 
-    double getRandomStepLength(const BaseMaterial&  material);
+    double getRandomStepLength(const BaseMaterial&  material, RandomGenerator& rng);
 
     /**
      * @brief Apply a random scattering to simulate multiple Coulomb scattering.
@@ -53,16 +54,18 @@ public:
      * This modifies the particle’s direction due to interaction with nuclei/electrons.
      * 
      * @param material Reference to the material
+     * @param rng Random number context of the current worker
      */
-    void elasticScatter(const BaseMaterial& material);
+    void elasticScatter(const BaseMaterial& material, RandomGenerator& rng);
 
     /**
      * @brief Compute a thermal (Brownian-like) step based on the material’s diffusion coefficient.
      * 
      * @param material Reference to the material
+     * @param rng Random number context of the current worker
      * @return A 3D displacement vector due to thermal motion
      */
-    std::array<double, 3> getThermalStep(const BaseMaterial& material);
+    std::array<double, 3> getThermalStep(const BaseMaterial& material, RandomGenerator& rng);
 
     /**
      * @brief Apply a drag force to reduce the particle's velocity over time.
@@ -77,9 +80,10 @@ public:
      * @brief Determines whether the particle is absorbed in the material.
      * 
      * @param material Reference to the material
+     * @param rng Random number context of the current worker
      * @return true if absorbed based on a random draw and material properties
      */
-    bool getAbsorption(const BaseMaterial& material) const override;
+    bool getAbsorption(const BaseMaterial& material, RandomGenerator& rng) const override;
 
     /**
      * @brief Check if the particle has been absorbed (after propagation).
@@ -92,8 +96,9 @@ public:
      * @brief Propagate the particle through a composite material (e.g., double slab).
      * 
      * @param doubleSlab Composite geometry of two slabs
+     * @param rng Random number context of the current worker
      */
-    void propagate(const DoubleSlab& doubleSlab);
+    void propagate(const DoubleSlab& doubleSlab, RandomGenerator& rng);
 
 private:
     double charge;        ///< Electric charge of the particle
@@ -3,6 +3,7 @@
 
 #include "particle.hpp"
 #include "regularslab.hpp"
+#include "boundscheck.hpp"
 #include <memory>
 
 /**
@@ -99,6 +100,14 @@ public:
      */
     bool isWithinBounds(const Particle& particle) const override;
 
+    /// Same as isWithinBounds, on a bare position (no virtual call)
+    bool contains(double x, double, double) const { return x >= xinit && x <= xinit + totalLength; }
+
+    /// contains() on n positions stored as structure of arrays (see BoundsCheck)
+    void containsBatch(const double* x, const double*, const double*, std::uint8_t* inside, int n) const {
+        BoundsCheck::interval(x, xinit, xinit + totalLength, inside, n);
+    }
+
     virtual ~DoubleSlab() = default;
 };
 
@@ -0,0 +1,45 @@
+#ifndef ELASTICSCATTER_HPP
+#define ELASTICSCATTER_HPP
+
+#include <array>
+
+/**
+ * @brief Elastic scattering off a nucleus at rest, shared by every particle type.
+ *
+ * The particle (mass m, velocity v) goes to the centre-of-mass frame of the collision,
+ * v_cm = (m v) / (m + A), takes a new direction u there at the same relative speed,
+ * and comes back: v' = |v - v_cm| u + v_cm. The particle type only enters through the
+ * mass ratio m / (m + A): a neutron is m = 1 in units of the nucleon mass.
+ *
+ * The directions are sampled by the caller, after checking that the particle moves
+ * (a particle at rest does not scatter and draws nothing). The batch version scatters
+ * n collisions stored as structure of arrays, four or eight per instruction at the
+ * selected simdLevel(); every level gives the same velocities, bit for bit, as the
+ * single collision.
+ */
+struct ElasticScatter {
+    /**
+     * @brief Scatters one particle.
+     *
+     * @param mass Mass of the particle
+     * @param atomicMass Mass of the nucleus (> 0)
+     * @param velocity Velocity of the particle, replaced by the velocity after the collision
+     * @param direction Unit direction in the centre-of-mass frame
+     */
+    static void apply(double mass, double atomicMass, std::array<double, 3>& velocity,
+                      const std::array<double, 3>& direction);
+
+    /**
+     * @brief Scatters n particles of the same mass.
+     *
+     * @param mass Mass of the particles
+     * @param atomicMass Mass of the nucleus of each collision (> 0)
+     * @param vx, vy, vz Velocities, replaced by the velocities after the collisions
+     * @param ux, uy, uz Unit directions in the centre-of-mass frame
+     * @param n Number of collisions
+     */
+    static void apply(double mass, const double* atomicMass, double* vx, double* vy, double* vz,
+                      const double* ux, const double* uy, const double* uz, int n);
+};
+
+#endif // ELASTICSCATTER_HPP
@@ -0,0 +1,162 @@
+#ifndef EVENTTRANSPORT_HPP
+#define EVENTTRANSPORT_HPP
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "basematerial.hpp"
+#include "regularslab.hpp"
+#include "finiteslab.hpp"
+#include "sphere.hpp"
+#include "doubleslab.hpp"
+#include "rng.hpp"
+#include "sobol.hpp"
+#include "transport.hpp"
+
+/**
+ * @brief Particles in flight of the event-based loop, as structure of arrays.
+ *
+ * One entry (lane) per particle; each phase of the loop sweeps one or two of these
+ * arrays over the whole bank instead of chasing a heap-allocated Particle through
+ * virtual calls.
+ */
+struct ParticleBank {
+    std::vector<double> x, y, z;        ///< Position
+    std::vector<double> vx, vy, vz;     ///< Velocity
+    std::vector<double> energy;         ///< Kinetic energy, 0.5 m v^2 (at load, then after each energy loss)
+    std::vector<std::uint8_t> alive;    ///< 1 while the history is running
+    std::vector<std::int8_t> region;    ///< Region of the next collision (0 or 1 in a double slab, 0 otherwise)
+    std::vector<std::uint8_t> stopped;  ///< Charged particle that lost all its energy
+    std::vector<std::uint8_t> moves;    ///< The flight ends in a collision (otherwise a straight double-slab step)
+    std::vector<double> tx, ty, tz;     ///< Displacement sampled for the current flight
+    std::vector<double> path;           ///< Length of the sampled displacement (energy loss)
+    std::vector<std::int64_t> history;  ///< History index of the lane inside the replica
+    std::vector<std::uint8_t> inside;   ///< Bounds check of the geometry after the move
+    std::vector<std::uint8_t> in1, in2; ///< Position within each region of a double slab
+
+    /// Resizes every array to the given number of lanes
+    void resize(int lanes);
+
+    /// @return Number of lanes
+    int size() const { return static_cast<int>(x.size()); }
+};
+
+/**
+ * @brief Elastic collisions of a step, packed for ElasticScatter.
+ *
+ * The colliding lanes of the bank, with their velocity, the direction already drawn from
+ * their generator and the atomic mass of their region.
+ */
+struct ScatterBatch {
+    std::vector<int> lane;
+    std::vector<double> vx, vy, vz;
+    std::vector<double> ux, uy, uz;
+    std::vector<double> atomicMass;
+    int size = 0;
+
+    /// Makes room for the given number of collisions
+    void resize(int lanes);
+};
+
+/**
+ * @brief Event-based transport of the histories of a replica.
+ *
+ * Histories are loaded into a ParticleBank and advanced all together, phase by phase:
+ * sample the flight, move, collide (scatter or drag, energy loss), check the boundary,
+ * absorb. Finished lanes are reloaded with the next history of the range, so the bank
+ * stays full until the range runs out.
+ *
+ * Each lane owns a RandomGenerator positioned on the (seed, replica, history) stream of
+ * its history, and every phase draws from each stream in the same order as the analog
+ * loop (transportHistory). Tallies are therefore identical to the analog ones, which
+ * stays available as a reference (TransportSettings::transport = "analog").
+ *
+ * The loop is a kernel templated on the particle type and the concrete geometry, one
+ * instantiation per {neutron, charged} x {RegularSlab, FiniteSlab, Sphere, DoubleSlab},
+ * picked once per material: the compiler sees the whole step, with the bounds checks
+ * and the particle physics inlined and no virtual call or dynamic_cast left in it.
+ * Bounds checks run once per phase over the positions of the whole bank
+ * (Geometry::containsBatch, vectorized by BoundsCheck), and the elastic collisions of a
+ * step are scattered together (ElasticScatter).
+ * Each kernel is further specialized on the physics the material actually has
+ * (elastic scattering, drag), so inactive physics compiles away.
+ */
+class EventTransport {
+public:
+    /**
+     * @brief Builds an engine with one lane per generator.
+     *
+     * @param settings Settings of the run
+     * @param generators Generators of the lanes, all on the run seed
+     */
+    EventTransport(const TransportSettings& settings, std::vector<std::unique_ptr<RandomGenerator>> generators);
+
+    /**
+     * @brief Transports the histories [begin, end) of a replica.
+     *
+     * Counts every outcome in tally and keeps the first histories of each outcome of the
+     * range as replay candidates, as the analog loop does.
+     *
+     * @param material Material of the replica
+     * @param run Replica index
+     * @param begin First history
+     * @param end One past the last history
+     * @param tally Tally of the replica for this worker
+     * @throws std::runtime_error if the material is not one of the four geometries
+     */
+    void transport(const BaseMaterial& material, int run, std::int64_t begin, std::int64_t end, ReplicaTally& tally);
+
+private:
+    /// Collision parameters of a region of the geometry
+    struct Region {
+        double lambda, pabs, k, atomicMass, stoppingPower;
+    };
+
+    /// Instantiation of the kernel for one particle type and geometry
+    typedef void (EventTransport::*Kernel)(const BaseMaterial& material, int run, std::int64_t begin, std::int64_t end);
+
+    const TransportSettings& settings;
+    const bool charged;
+    std::vector<std::unique_ptr<RandomGenerator>> generators;
+    ParticleBank bank;
+    ScatterBatch scatters;
+    std::vector<int> active;                  ///< Lanes alive at the current step
+    std::vector<std::uint8_t> outcomes;       ///< Outcome of each history of the range
+
+    // Current material
+    const BaseMaterial* prepared = nullptr;
+    Kernel kernel = nullptr;
+    Region regions[2];
+    bool hasEntryPlane = false;
+    double entryPlane = 0.0;
+
+    /// Kernel of a geometry for the physics flags given at run time (see the .cpp)
+    template <typename Geometry, bool... Flags>
+    struct KernelTable;
+
+    void prepare(const BaseMaterial& material);
+    void load(int lane, int run, std::int64_t history, const ScrambledSobol& sobol);
+
+    template <typename Kind, typename Geometry>
+    void runKernel(const BaseMaterial& material, int run, std::int64_t begin, std::int64_t end);
+
+    template <typename Geometry>
+    void locate(const Geometry&, int) {}
+    void locate(const DoubleSlab& geometry, int lanes);
+
+    template <typename Geometry>
+    void sampleFlight(const Geometry& geometry, int lane);
+    void sampleFlight(const DoubleSlab& geometry, int lane);
+
+    template <typename Kind>
+    void scatter();
+    template <typename Kind>
+    void collide(int lane);
+
+    template <typename Kind, typename Geometry>
+    bool absorbs(const Geometry& geometry, int lane);
+    template <typename Kind>
+    bool absorbs(const DoubleSlab& geometry, int lane);
+};
+
+#endif // EVENTTRANSPORT_HPP
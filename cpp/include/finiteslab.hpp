@@ -3,6 +3,7 @@
 
 #include "basematerial.hpp"
 #include "simplematerial.hpp"
+#include "boundscheck.hpp"
 
 /**
  * @brief Represents a finite 3D slab of material with rectangular dimensions.
@@ -54,6 +55,18 @@ public:
      * @return true if the particle lies within the defined 3D box.
      */
     bool isWithinBounds(const Particle& particle) const override;
+
+    /// Same as isWithinBounds, on a bare position (no virtual call)
+    bool contains(double x, double y, double z) const {
+        return x >= - xlength/2 && x <= xlength/2 && y >= - ylength/2 && y <= ylength/2 && z >= 0 && z <= zlength;
+    }
+
+    /// contains() on n positions stored as structure of arrays (see BoundsCheck)
+    void containsBatch(const double* x, const double* y, const double* z, std::uint8_t* inside, int n) const {
+        const std::array<double, 3> lo = {- xlength/2, - ylength/2, 0.0};
+        const std::array<double, 3> hi = {xlength/2, ylength/2, zlength};
+        BoundsCheck::box(x, y, z, lo, hi, inside, n);
+    }
 };
 
 #endif // FINITESLAB_HPP
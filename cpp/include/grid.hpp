@@ -0,0 +1,87 @@
+#ifndef GRID_HPP
+#define GRID_HPP
+
+#include <string>
+#include <vector>
+#include "json.hpp"
+#include "configerror.hpp"
+#include "transport.hpp"
+
+using json = nlohmann::json;
+
+/**
+ * @brief One parameter of a grid scan and the values it takes.
+ *
+ * Read from the "grid" section of the configuration, where every key is a
+ * "material.<field>" or "geometry.<field>" path and its value an array of numbers.
+ * "geometry.scale" is the length passed to MaterialFactory::createMaterial.
+ */
+struct GridAxis {
+    std::string section;         ///< "material" or "geometry"
+    std::string field;           ///< Key inside the section
+    std::vector<double> values;  ///< Values of the scan
+
+    /// @return The "section.field" path, as in the configuration
+    std::string name() const { return section + "." + field; }
+};
+
+/// One combination of the grid
+struct GridJob {
+    std::vector<double> values;  ///< One value per axis, in axis order
+    json config;                 ///< Configuration with the values applied
+    double scale;                ///< Length passed to the material factory
+    double estimatedCost;        ///< Rough cost of one history, used to order the jobs
+};
+
+/// Result of one combination of the grid
+struct GridPoint {
+    GridJob job;
+    TransportResult result;
+};
+
+/**
+ * @brief Checks the "grid" section of a configuration.
+ *
+ * Records an error for keys outside material/geometry, for fields the base section does
+ * not have (except geometry.scale), for empty or non-numeric value arrays, and when
+ * neither the grid nor geometry.scale gives the scale. Once the keys are valid, every
+ * expanded job configuration goes through MaterialFactory::validate_config.
+ */
+void validateGrid(const json& config, ConfigError& error);
+
+/// @return The axes of the grid, in alphabetical order of their paths
+std::vector<GridAxis> gridAxes(const json& config);
+
+/**
+ * @brief Expands the grid into one job per combination.
+ *
+ * The last axis varies fastest.
+ */
+std::vector<GridJob> expandGrid(const json& config);
+
+/**
+ * @brief Rough number of collisions of one history.
+ *
+ * A random walk needs about (L / mean_free_path)^2 collisions to leave a body of size L
+ * and about 1 / pabs to be absorbed; the estimate is the smaller of the two. It is
+ * only used to start the most expensive jobs first.
+ */
+double estimateHistoryCost(const json& config, const std::string& shape, double scale);
+
+/**
+ * @brief Runs every combination of the grid as one batch on a shared pool of workers.
+ *
+ * The configuration is parsed once and one material is built per job. Jobs are handed
+ * to the scheduler in decreasing order of estimated cost, so the long ones start first
+ * and the cheap ones fill the gaps at the end. Every job uses the run seed (common
+ * random numbers), so neighbouring points of the grid differ by much less noise than
+ * independent runs.
+ *
+ * @param config Validated configuration with a grid section
+ * @param settings Settings of the run
+ * @return One point per combination, in expansion order
+ * @throws std::runtime_error if the particle starts outside the material of a job
+ */
+std::vector<GridPoint> runGrid(const json& config, const TransportSettings& settings);
+
+#endif // GRID_HPP
@@ -0,0 +1,98 @@
+#ifndef MPSCQUEUE_HPP
+#define MPSCQUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+/**
+ * @brief Bounded lock-free queue for many producers and a single consumer.
+ *
+ * Ring buffer of cells tagged with sequence numbers (D. Vyukov's bounded queue):
+ * producers claim a slot with one compare-and-swap on the enqueue position and publish
+ * it by bumping the cell sequence; the consumer owns the dequeue position and needs no
+ * atomic read-modify-write at all. Neither side ever blocks: tryPush fails when the
+ * queue is full and tryPop when it is empty.
+ *
+ * @tparam T Element type, must be default-constructible and movable
+ */
+template <typename T>
+class BoundedMpscQueue {
+public:
+    /**
+     * @brief Construct an empty queue.
+     *
+     * @param capacity Number of elements, rounded up to a power of two
+     */
+    explicit BoundedMpscQueue(std::size_t capacity) {
+        std::size_t size = 2;
+        while (size < capacity) size *= 2;
+        mask = size - 1;
+        cells.reset(new Cell[size]);
+        for (std::size_t i = 0; i < size; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        enqueuePos.store(0, std::memory_order_relaxed);
+        dequeuePos = 0;
+    }
+
+    BoundedMpscQueue(const BoundedMpscQueue&) = delete;
+    BoundedMpscQueue& operator=(const BoundedMpscQueue&) = delete;
+
+    /**
+     * @brief Appends an element (any thread).
+     *
+     * @return false if the queue is full; value is then left untouched
+     */
+    bool tryPush(T& value) {
+        std::size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const std::intptr_t diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest element (consumer thread only).
+     *
+     * @return false if the queue is empty
+     */
+    bool tryPop(T& value) {
+        Cell& cell = cells[dequeuePos & mask];
+        if (cell.sequence.load(std::memory_order_acquire) != dequeuePos + 1) return false;
+        value = std::move(cell.value);
+        cell.sequence.store(dequeuePos + mask + 1, std::memory_order_release);
+        ++dequeuePos;
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    // Producer and consumer positions on separate cache lines
+    std::unique_ptr<Cell[]> cells;
+    std::size_t mask;
+    char padProducer[64];
+    std::atomic<std::size_t> enqueuePos;
+    char padConsumer[64];
+    std::size_t dequeuePos;
+};
+
+#endif // MPSCQUEUE_HPP
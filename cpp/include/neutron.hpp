@@ -20,15 +20,15 @@ public:
 
     virtual ~Neutron() = default;
     
-    double getRandomStepLength(const BaseMaterial& material);
-    std::array<double, 3> getThermalStep(const BaseMaterial& material);
+    double getRandomStepLength(const BaseMaterial& material, RandomGenerator& rng);
+    std::array<double, 3> getThermalStep(const BaseMaterial& material, RandomGenerator& rng);
 
-    void elasticScatter(const BaseMaterial&  material);
+    void elasticScatter(const BaseMaterial&  material, RandomGenerator& rng);
     void applyDragForce(const BaseMaterial& material);
-    void propagate(const BaseMaterial&  material) override;
-    void propagate(const DoubleSlab& doubleSlab);
-    bool getAbsorption(const BaseMaterial&  material) const override;
-    bool getAbsorption(const DoubleSlab&  material) const;
+    void propagate(const BaseMaterial&  material, RandomGenerator& rng) override;
+    void propagate(const DoubleSlab& doubleSlab, RandomGenerator& rng);
+    bool getAbsorption(const BaseMaterial&  material, RandomGenerator& rng) const override;
+    bool getAbsorption(const DoubleSlab&  material, RandomGenerator& rng) const;
 };
 
 #endif
@@ -5,13 +5,16 @@
 #include <vector>
 #include <array>
 #include <string> 
+#include <utility>
 #include "basematerial.hpp"
+#include "rng.hpp"
 
 class Particle {
 protected:
     std::array<double, 3> position;
     std::array<double, 3> velocity;
     std::vector<std::array<double, 3>> history;
+    bool recordHistory = false;
 
 public:
     Particle(double x, double y, double z, double vx, double vy, double vz)
@@ -19,16 +22,21 @@ public:
 
     virtual ~Particle() = default;
 
-    void appendHistory();
+    // Trajectories are only kept when asked for (replay of a single history)
+    void setRecordHistory(bool record) { recordHistory = record; }
+    void appendHistory() { if (recordHistory) history.push_back(position); }
     void saveHistoryToFile(const std::string& filename) const;
+    // Hands the recorded trajectory over (e.g. to a TrajectoryWriter), leaving it empty
+    std::vector<std::array<double, 3>> takeHistory() { return std::move(history); }
 
-    std::pair<double, double> getRandomSphericalCoordinates();
+    // Unit vector uniformly distributed on the sphere
+    std::array<double, 3> sampleIsotropicDirection(RandomGenerator& rng) const { return rng.isotropicDirection(); }
 
     std::array<double, 3> getPosition() const { return position; }
     std::array<double, 3> getVelocity() const { return velocity; }
 
-    virtual void propagate(const BaseMaterial& material) = 0;
-    virtual bool getAbsorption(const BaseMaterial& material) const = 0;
+    virtual void propagate(const BaseMaterial& material, RandomGenerator& rng) = 0;
+    virtual bool getAbsorption(const BaseMaterial& material, RandomGenerator& rng) const = 0;
 };
 
 #endif
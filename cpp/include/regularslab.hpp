@@ -3,6 +3,7 @@
 
 #include "basematerial.hpp"
 #include "simplematerial.hpp"
+#include "boundscheck.hpp"
 
 class RegularSlab : public SimpleMaterial {
 private:
@@ -19,6 +20,14 @@ public:
     virtual ~RegularSlab() = default;
 
     bool isWithinBounds(const Particle& particle) const override;
+
+    /// Same as isWithinBounds, on a bare position (no virtual call)
+    bool contains(double x, double, double) const { return x >= xinit && x <= length + xinit; }
+
+    /// contains() on n positions stored as structure of arrays (see BoundsCheck)
+    void containsBatch(const double* x, const double*, const double*, std::uint8_t* inside, int n) const {
+        BoundsCheck::interval(x, xinit, length + xinit, inside, n);
+    }
     
 };
 
@@ -0,0 +1,200 @@
+#ifndef RNG_HPP
+#define RNG_HPP
+
+#include <array>
+#include <cstdint>
+#include "sobol.hpp"
+
+/**
+ * @brief Philox4x32-10 counter-based generator (Salmon et al., SC'11).
+ *
+ * A pure function that maps a 128-bit counter and a 64-bit key to 128 random bits.
+ * There is no state to carry around: any block of any stream can be computed on
+ * demand, which is what makes histories reproducible independently of the thread
+ * that runs them.
+ */
+struct Philox4x32 {
+    typedef std::array<std::uint32_t, 4> Counter;
+    typedef std::array<std::uint32_t, 2> Key;
+
+    /**
+     * @brief Encrypts a counter with the given key (10 rounds).
+     *
+     * @param ctr Counter block
+     * @param key Key of the stream
+     * @return 128 random bits as four 32-bit words
+     */
+    static Counter generate(Counter ctr, Key key) {
+        for (int r = 0; r < 10; ++r) {
+            if (r > 0) {
+                key[0] += 0x9E3779B9u;
+                key[1] += 0xBB67AE85u;
+            }
+            const std::uint64_t p0 = static_cast<std::uint64_t>(0xD2511F53u) * ctr[0];
+            const std::uint64_t p1 = static_cast<std::uint64_t>(0xCD9E8D57u) * ctr[2];
+            ctr = {{static_cast<std::uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0],
+                    static_cast<std::uint32_t>(p1),
+                    static_cast<std::uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1],
+                    static_cast<std::uint32_t>(p0)}};
+        }
+        return ctr;
+    }
+
+    /**
+     * @brief Fills a buffer with random 64-bit words.
+     *
+     * Consumes n/2 consecutive blocks, incrementing the first counter word from
+     * ctr[0]. Runs eight blocks per iteration with AVX2 when the CPU supports it;
+     * the scalar fallback gives bit-identical values.
+     *
+     * @param ctr First counter block
+     * @param key Key of the stream
+     * @param out Output buffer
+     * @param n Number of words to write (must be even)
+     */
+    static void bits(Counter ctr, Key key, std::uint64_t* out, int n);
+
+    /// @return true if bits() uses the AVX2 kernel on this machine
+    static bool simdAvailable();
+
+    /**
+     * @brief Enables or disables the AVX2 kernel (e.g. to benchmark the scalar path).
+     *
+     * Has no effect on machines without AVX2.
+     */
+    static void setSimdEnabled(bool enabled);
+};
+
+/**
+ * @brief Random number context owned by each worker and passed down to the particles.
+ *
+ * Every history has its own stream that depends only on the run seed and on the
+ * (replica, history) indices: the tallies are identical whatever the number of
+ * threads and whichever thread picks up a given history, and no generator state is
+ * shared or locked.
+ *
+ * Samples are produced in batches. Uniforms, exponential path lengths and isotropic
+ * directions each have a buffer, filled in bulk from a separate sub-stream of the
+ * history, so the transport loop only pops precomputed values.
+ *
+ * The random words behind the buffers come from an engine chosen at compile time,
+ * see BasicRandomGenerator in rngengines.hpp. Only the bulk refill goes through a
+ * virtual call; the draws themselves are inline.
+ */
+class RandomGenerator {
+public:
+    /// Number of samples produced per refill of each buffer
+    static const int kBatch = 16;
+
+    virtual ~RandomGenerator() = default;
+
+    /**
+     * @brief Draws a non-deterministic seed from std::random_device.
+     *
+     * Used when the configuration does not fix run.seed.
+     */
+    static std::uint64_t randomSeed();
+
+    /// @return Name of the engine behind the generator
+    virtual const char* engineName() const = 0;
+
+    /**
+     * @brief Moves the generator to the start of the stream of one history.
+     *
+     * Discards whatever is left in the buffers.
+     *
+     * @param replica Index of the statistical replica
+     * @param history Index of the history inside the replica
+     */
+    void setStream(std::uint32_t replica, std::uint64_t history) {
+        currentReplica = replica;
+        currentHistory = history;
+        for (int s = 0; s < kSubStreams; ++s) restart[s] = true;
+        uniformIndex = exponentialIndex = directionIndex = kBatch;
+    }
+
+    /**
+     * @brief Replaces the first samples of the current history by a quasi-random point.
+     *
+     * Used by the randomized quasi-Monte Carlo sampler: the first exponential path
+     * length, the first direction and the first uniform (the first absorption draw in
+     * single-material geometries) come from the point, everything after them from the
+     * pseudo-random stream. Must be called right after setStream().
+     *
+     * @param point Scrambled Sobol point of the history
+     */
+    void setLeadingSamples(const ScrambledSobol::Point& point);
+
+    /// @return Uniform double in [0, 1) with 53 random bits
+    double uniform() {
+        if (uniformIndex == kBatch) fillUniforms();
+        return uniforms[uniformIndex++];
+    }
+
+    /// @return Exponentially distributed double with unit mean (ziggurat method)
+    double exponential() {
+        if (exponentialIndex == kBatch) fillExponentials();
+        return exponentials[exponentialIndex++];
+    }
+
+    /// @return Unit vector uniformly distributed on the sphere
+    std::array<double, 3> isotropicDirection() {
+        if (directionIndex == kBatch) fillDirections();
+        return directions[directionIndex++];
+    }
+
+protected:
+    /// Independent sub-streams of a history, one per sample buffer
+    enum SubStream {
+        kUniformStream = 0,
+        kExponentialStream = 1,
+        kDirectionStream = 2,
+        kSubStreams = 3
+    };
+
+    /**
+     * @brief Construct a generator for a run.
+     *
+     * @param seed Seed of the run (run.seed in the configuration)
+     */
+    explicit RandomGenerator(std::uint64_t seed);
+
+    /**
+     * @brief Produces the next random words of a sub-stream of the current history.
+     *
+     * @param subStream Sub-stream to draw from
+     * @param restart true on the first call after setStream(): the engine must first
+     *        move to the start of the (seed, replica, history, subStream) stream
+     * @param out Output buffer
+     * @param n Number of words to write (even)
+     */
+    virtual void words(SubStream subStream, bool restart, std::uint64_t* out, int n) = 0;
+
+    std::uint64_t seed;              ///< Seed of the run
+    std::uint32_t currentReplica;    ///< Replica of the current history
+    std::uint64_t currentHistory;    ///< Index of the current history
+
+private:
+    bool restart[kSubStreams];
+
+    double uniforms[kBatch];
+    double exponentials[kBatch];
+    std::array<double, 3> directions[kBatch];
+
+    int uniformIndex, exponentialIndex, directionIndex;
+
+    void fillUniforms();
+    void fillExponentials();
+    void fillDirections();
+
+    void nextWords(SubStream subStream, std::uint64_t* out, int n) {
+        words(subStream, restart[subStream], out, n);
+        restart[subStream] = false;
+    }
+
+    static double toUniform(std::uint64_t word) {
+        return (word >> 11) * (1.0 / 9007199254740992.0);
+    }
+};
+
+#endif // RNG_HPP
@@ -0,0 +1,174 @@
+#ifndef RNGENGINES_HPP
+#define RNGENGINES_HPP
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include "rng.hpp"
+
+/*
+ * Random engines that can back a RandomGenerator.
+ *
+ * An engine is a policy class with:
+ *   static const char* name();
+ *   void seed(std::uint64_t seed, std::uint32_t replica, std::uint64_t history, std::uint32_t subStream);
+ *   void fill(std::uint64_t* out, int n);
+ *
+ * seed() moves the engine to the start of the stream of one (replica, history,
+ * sub-stream) of the run, so every engine keeps histories reproducible regardless of
+ * the thread that runs them. Only Philox does it by construction; the stateful
+ * engines are reseeded from a hash of the indices.
+ */
+
+/// Hashes the coordinates of a stream into a 64-bit seed (splitmix64 chain)
+inline std::uint64_t streamSeed(std::uint64_t seed, std::uint32_t replica, std::uint64_t history, std::uint32_t subStream) {
+    auto mix = [](std::uint64_t x) {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    };
+    std::uint64_t h = mix(seed);
+    h = mix(h ^ replica);
+    h = mix(h ^ history);
+    return mix(h ^ subStream);
+}
+
+/// Philox4x32-10: the counter encodes (sub-stream, draw, replica, history)
+struct PhiloxEngine {
+    static const char* name() { return "philox"; }
+
+    void seed(std::uint64_t seed, std::uint32_t replica, std::uint64_t history, std::uint32_t subStream) {
+        key = {{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)}};
+        counter = {{subStream << 30, replica,
+                    static_cast<std::uint32_t>(history),
+                    static_cast<std::uint32_t>(history >> 32)}};
+    }
+
+    void fill(std::uint64_t* out, int n) {
+        Philox4x32::bits(counter, key, out, n);
+        counter[0] += n / 2;
+    }
+
+private:
+    Philox4x32::Key key;
+    Philox4x32::Counter counter;
+};
+
+/// xoshiro256++ (Blackman & Vigna), state expanded from the stream seed with splitmix64
+struct Xoshiro256ppEngine {
+    static const char* name() { return "xoshiro256pp"; }
+
+    void seed(std::uint64_t seed, std::uint32_t replica, std::uint64_t history, std::uint32_t subStream) {
+        std::uint64_t x = streamSeed(seed, replica, history, subStream);
+        for (int i = 0; i < 4; ++i) {
+            std::uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            state[i] = z ^ (z >> 31);
+        }
+    }
+
+    void fill(std::uint64_t* out, int n) {
+        for (int i = 0; i < n; ++i) {
+            const std::uint64_t result = rotl(state[0] + state[3], 23) + state[0];
+            const std::uint64_t t = state[1] << 17;
+            state[2] ^= state[0];
+            state[3] ^= state[1];
+            state[1] ^= state[2];
+            state[0] ^= state[3];
+            state[2] ^= t;
+            state[3] = rotl(state[3], 45);
+            out[i] = result;
+        }
+    }
+
+private:
+    std::uint64_t state[4];
+
+    static std::uint64_t rotl(std::uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+};
+
+/// PCG64 (XSL RR 128/64, O'Neill), stream selected through the increment. Outputs the
+/// permuted state after each step, as pcg64 of the PCG library and numpy's PCG64.
+struct Pcg64Engine {
+    static const char* name() { return "pcg64"; }
+
+    void seed(std::uint64_t seed, std::uint32_t replica, std::uint64_t history, std::uint32_t subStream) {
+        const std::uint64_t s = streamSeed(seed, replica, history, subStream);
+        increment = (static_cast<unsigned __int128>(streamSeed(s, 0, 0, 0)) << 1) | 1u;
+        state = 0;
+        step();
+        state += s;
+        step();
+    }
+
+    void fill(std::uint64_t* out, int n) {
+        for (int i = 0; i < n; ++i) {
+            step();
+            const std::uint64_t xsl = static_cast<std::uint64_t>(state >> 64) ^ static_cast<std::uint64_t>(state);
+            const unsigned rot = static_cast<unsigned>(state >> 122);
+            out[i] = (xsl >> rot) | (xsl << ((64 - rot) & 63));
+        }
+    }
+
+private:
+    unsigned __int128 state;
+    unsigned __int128 increment;
+
+    void step() {
+        const unsigned __int128 multiplier =
+            (static_cast<unsigned __int128>(2549297995355413924ULL) << 64) | 4865540595714422341ULL;
+        state = state * multiplier + increment;
+    }
+};
+
+/// std::mt19937_64, reseeded from the stream seed at the start of every history
+struct Mt19937_64Engine {
+    static const char* name() { return "mt19937_64"; }
+
+    void seed(std::uint64_t seed, std::uint32_t replica, std::uint64_t history, std::uint32_t subStream) {
+        engine.seed(streamSeed(seed, replica, history, subStream));
+    }
+
+    void fill(std::uint64_t* out, int n) {
+        for (int i = 0; i < n; ++i) out[i] = engine();
+    }
+
+private:
+    std::mt19937_64 engine;
+};
+
+/**
+ * @brief RandomGenerator backed by a given engine policy.
+ *
+ * Keeps one engine per sub-stream; each one is moved to its stream the first time the
+ * sub-stream is used in a history.
+ */
+template <typename Engine>
+class BasicRandomGenerator final : public RandomGenerator {
+public:
+    explicit BasicRandomGenerator(std::uint64_t seed) : RandomGenerator(seed) {}
+
+    const char* engineName() const override { return Engine::name(); }
+
+protected:
+    void words(SubStream subStream, bool restart, std::uint64_t* out, int n) override {
+        Engine& engine = engines[subStream];
+        if (restart) engine.seed(seed, currentReplica, currentHistory, subStream);
+        engine.fill(out, n);
+    }
+
+private:
+    Engine engines[kSubStreams];
+};
+
+/// @return Names accepted by --rng, default first
+inline std::vector<std::string> rngEngineNames() {
+    return {PhiloxEngine::name(), Xoshiro256ppEngine::name(), Pcg64Engine::name(), Mt19937_64Engine::name()};
+}
+
+#endif // RNGENGINES_HPP
@@ -0,0 +1,128 @@
+#ifndef SCHEDULER_HPP
+#define SCHEDULER_HPP
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/// Time and work accounting of one worker of a parallel loop
+struct WorkerStats {
+    double busySeconds = 0.0;   ///< Time spent inside the loop body
+    double idleSeconds = 0.0;   ///< Rest of the wall time (looking for work, or finished early)
+    std::int64_t items = 0;     ///< Indices processed
+    std::int64_t chunks = 0;    ///< Calls to the loop body
+    std::int64_t steals = 0;    ///< Ranges taken from other workers
+    int cpu = -1;               ///< CPU the worker was pinned to (-1 if not pinned)
+    int node = -1;              ///< NUMA node of that CPU (-1 if not pinned)
+};
+
+/// Contiguous range of loop indices with an estimated cost
+struct WorkTask {
+    std::int64_t begin;  ///< First index
+    std::int64_t end;    ///< One past the last index
+    std::int64_t grain;  ///< Largest chunk of this range handed to the body at once
+    double cost;         ///< Estimated cost of the whole range (any unit)
+};
+
+/**
+ * @brief Work-stealing runtime for loops over an index range.
+ *
+ * Each worker has a deque of index ranges, seeded with a contiguous block of the loop
+ * of equal estimated cost. A worker takes grain-sized pieces from the front of its own deque; when it
+ * runs dry it steals the back half of the last range of another worker. Ranges are
+ * only split when stolen, so a loop of cheap iterations costs a handful of steals,
+ * while a loop whose iterations vary by orders of magnitude in cost (long random
+ * walks next to particles that escape at once) keeps every worker busy to the end.
+ *
+ * The calling thread acts as worker 0, unless workers are pinned to CPUs: then every
+ * worker is a new thread, bound to the CPUs of CpuTopology in its pinning order, and
+ * the calling thread only waits.
+ */
+class WorkStealingScheduler {
+public:
+    /**
+     * @brief Loop body.
+     *
+     * @param worker Index of the worker running the chunk, in [0, workers)
+     * @param begin First index of the chunk
+     * @param end One past the last index of the chunk
+     */
+    typedef std::function<void(int worker, std::int64_t begin, std::int64_t end)> Body;
+
+    /**
+     * @brief Per-worker setup, run on the worker thread before its first chunk.
+     *
+     * Memory the worker allocates here is first touched by the worker itself, so with
+     * pinned workers it is placed on the NUMA node the worker runs on.
+     */
+    typedef std::function<void(int worker)> WorkerInit;
+
+    /**
+     * @brief Construct a scheduler.
+     *
+     * @param workers Number of worker threads (at least 1)
+     * @param pin Bind each worker to a CPU
+     * @param firstCpu Position in the pinning order of the CPU of worker 0 (lets
+     *        several processes pin their workers to different CPUs)
+     */
+    explicit WorkStealingScheduler(int workers, bool pin = false, int firstCpu = 0);
+
+    /// @return Number of workers
+    int workers() const { return numWorkers; }
+
+    /**
+     * @brief Runs body over [0, n) and returns when every index is done.
+     *
+     * The split of the range into chunks depends on timing; bodies must only write
+     * to per-worker state (indexed by the worker argument) or to per-index state.
+     * An exception thrown by a body is rethrown here after all workers stop.
+     *
+     * @param n Number of indices
+     * @param grain Largest chunk handed to the body at once
+     * @param body Loop body
+     */
+    void parallelFor(std::int64_t n, std::int64_t grain, const Body& body);
+
+    /// Same as above, running init on every worker thread first
+    void parallelFor(std::int64_t n, std::int64_t grain, const Body& body, const WorkerInit& init);
+
+    /**
+     * @brief Runs body over a list of tasks of known cost.
+     *
+     * Tasks must be in increasing index order and must not overlap. Each worker starts
+     * with a contiguous share of the tasks of equal total cost (see partition), and
+     * expensive tasks can be given a smaller grain than cheap ones.
+     */
+    void parallelFor(const std::vector<WorkTask>& tasks, const Body& body, const WorkerInit& init);
+
+    /**
+     * @brief Splits a list of tasks into contiguous parts of equal total cost.
+     *
+     * A task across a boundary is cut, assuming its cost is spread evenly over its
+     * indices.
+     *
+     * @param tasks Tasks in increasing index order
+     * @param parts Number of parts
+     * @return parts lists of tasks, some possibly empty
+     */
+    static std::vector<std::vector<WorkTask>> partition(const std::vector<WorkTask>& tasks, int parts);
+
+    /// @return Accounting of the last parallelFor, one entry per worker
+    const std::vector<WorkerStats>& stats() const { return workerStats; }
+
+    /**
+     * @brief Default grain for a loop of n indices.
+     *
+     * Small enough that the tail of the loop can be balanced, large enough that the
+     * deque locks are negligible.
+     */
+    static std::int64_t defaultGrain(std::int64_t n, int workers);
+
+private:
+    int numWorkers;
+    bool pin;
+    int firstCpu;
+    std::vector<WorkerStats> workerStats;
+};
+
+#endif // SCHEDULER_HPP
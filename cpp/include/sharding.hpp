@@ -0,0 +1,32 @@
+#ifndef SHARDING_HPP
+#define SHARDING_HPP
+
+#include <vector>
+#include "basematerial.hpp"
+#include "transport.hpp"
+
+/**
+ * @brief Runs a batch in several worker processes (--workers).
+ *
+ * The calling process acts as coordinator: it forks settings.processes workers, gives
+ * each a disjoint contiguous range of the history index space of the batch (see
+ * batchHistories) of equal estimated cost (see planBatch) and collects their tallies through an anonymous shared-memory
+ * segment. Each worker runs its range on settings.threads threads. Since every history
+ * draws from its own (seed, replica, history) stream, the result is identical to a
+ * single-process run.
+ *
+ * A worker that crashes does not take the run down: its range is run again once in a
+ * fresh process, which reproduces it exactly.
+ *
+ * The workerStats of every result hold one entry per process: times averaged and
+ * counts summed over its threads, node set if all its threads were pinned to one.
+ *
+ * @param settings Settings of the run
+ * @param materials Materials of the batch
+ * @return One result per material, in the same order
+ * @throws std::runtime_error if a range fails twice, or if processes cannot be created
+ */
+std::vector<TransportResult> runTransportSharded(const TransportSettings& settings,
+                                                 const std::vector<const BaseMaterial*>& materials);
+
+#endif // SHARDING_HPP
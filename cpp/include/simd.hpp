@@ -0,0 +1,29 @@
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+/**
+ * @brief Instruction set of the batch kernels of the transport loop (BoundsCheck,
+ * ElasticScatter).
+ *
+ * The best level of the CPU is detected once at start-up; every kernel gives the same
+ * result at every level.
+ */
+enum class SimdLevel { Scalar, Avx2, Avx512 };
+
+/// @return Best instruction set of this machine
+SimdLevel maxSimdLevel();
+
+/// @return Instruction set in use
+SimdLevel simdLevel();
+
+/**
+ * @brief Selects the instruction set (e.g. to benchmark the scalar path).
+ *
+ * Levels above maxSimdLevel() fall back to maxSimdLevel().
+ */
+void setSimdLevel(SimdLevel level);
+
+/// @return "scalar", "avx2" or "avx512"
+const char* simdLevelName(SimdLevel level);
+
+#endif // SIMD_HPP
@@ -0,0 +1,45 @@
+#ifndef SOBOL_HPP
+#define SOBOL_HPP
+
+#include <array>
+#include <cstdint>
+
+/**
+ * @brief Owen-scrambled Sobol points for randomized quasi-Monte Carlo.
+ *
+ * Provides the low-dimensional part of each history: the first free path, the first
+ * direction and the first absorption draw. Every scramble is an independent
+ * randomization of the same point set, so the spread of the tallies across scrambles
+ * is an unbiased error estimate, exactly like independent Monte Carlo replicas but
+ * with faster convergence.
+ *
+ * Scrambling uses the hash-based nested uniform scramble of Burley (2020).
+ */
+class ScrambledSobol {
+public:
+    /// Number of dimensions driven by the Sobol sequence
+    static const int kDimensions = 4;
+
+    typedef std::array<double, kDimensions> Point;
+
+    /**
+     * @brief Construct one randomization of the point set.
+     *
+     * @param seed Seed of the run
+     * @param scramble Index of the scramble (one per statistical replica)
+     */
+    ScrambledSobol(std::uint64_t seed, std::uint32_t scramble);
+
+    /**
+     * @brief Returns the scrambled point of a given index.
+     *
+     * @param index Index of the point (the history index)
+     * @return Point in [0, 1)^kDimensions
+     */
+    Point point(std::uint32_t index) const;
+
+private:
+    std::uint32_t scrambleSeeds[kDimensions];
+};
+
+#endif // SOBOL_HPP
@@ -3,7 +3,9 @@
 
 #include "basematerial.hpp"
 #include "simplematerial.hpp"
+#include "boundscheck.hpp"
 #include <array>
+#include <cmath>
 
 class Sphere : public SimpleMaterial {
 private:
@@ -18,6 +20,17 @@ public:
     virtual ~Sphere() = default;
 
     bool isWithinBounds(const Particle& particle) const override;
+
+    /// Same as isWithinBounds, on a bare position (no virtual call)
+    bool contains(double x, double y, double z) const {
+        double dist = std::sqrt(x * x + y * y + z * z);
+        return dist <= radius;
+    }
+
+    /// contains() on n positions stored as structure of arrays (see BoundsCheck)
+    void containsBatch(const double* x, const double* y, const double* z, std::uint8_t* inside, int n) const {
+        BoundsCheck::ball(x, y, z, radius, inside, n);
+    }
 };
 
 #endif
@@ -0,0 +1,40 @@
+#ifndef SWEEP_HPP
+#define SWEEP_HPP
+
+#include <vector>
+#include "transport.hpp"
+
+/// Result of one point of a geometry-size sweep
+struct SweepPoint {
+    double scale;            ///< Geometry size of the point
+    TransportResult result;  ///< Fractions of each replica
+};
+
+/**
+ * @brief Geometry sizes of a sweep, equally spaced between min and max.
+ *
+ * Sizes are truncated to two decimals, as Particle_Transport.sh always did.
+ *
+ * @param minScale First size
+ * @param maxScale Last size
+ * @param points Number of sizes (at least 2)
+ */
+std::vector<double> sweepScales(double minScale, double maxScale, int points);
+
+/**
+ * @brief Runs the transport for every geometry size in a single process.
+ *
+ * The materials of all sizes are run as one batch on the workers of settings.threads.
+ * Every point uses the same seed, so history i of replica r draws the same random
+ * stream at every size (common random numbers). The differences between neighbouring
+ * points are then strongly correlated and far less noisy than with independent runs.
+ *
+ * @param settings Settings of the run
+ * @param scales Geometry sizes
+ * @param materials Material of each size, built once from the configuration
+ * @return One result per size, in the same order
+ */
+std::vector<SweepPoint> runSweep(const TransportSettings& settings, const std::vector<double>& scales,
+                                 const std::vector<const BaseMaterial*>& materials);
+
+#endif // SWEEP_HPP
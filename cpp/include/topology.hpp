@@ -0,0 +1,32 @@
+#ifndef TOPOLOGY_HPP
+#define TOPOLOGY_HPP
+
+#include <vector>
+
+/**
+ * @brief Logical CPUs of the machine and the NUMA node (socket) of each.
+ *
+ * Read from /sys/devices/system on Linux. Elsewhere, or if sysfs is not available, all
+ * CPUs are reported on node 0 and pinning is a no-op.
+ */
+struct CpuTopology {
+    std::vector<int> cpus;   ///< CPUs the process may run on, in pinning order
+    std::vector<int> nodes;  ///< NUMA node of each entry of cpus
+
+    /**
+     * @brief Topology of this machine, detected once.
+     *
+     * The pinning order alternates between nodes (first CPU of node 0, first CPU of
+     * node 1, ...), so that any number of workers is spread evenly over the sockets.
+     */
+    static const CpuTopology& instance();
+
+    /**
+     * @brief Binds the calling thread to one CPU.
+     *
+     * @return false if the platform does not support it or the call failed
+     */
+    static bool pinCurrentThread(int cpu);
+};
+
+#endif // TOPOLOGY_HPP
@@ -0,0 +1,75 @@
+#ifndef TRAJECTORYWRITER_HPP
+#define TRAJECTORYWRITER_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mpscqueue.hpp"
+#include "transport.hpp"
+
+/// A finished history recorded during the run
+struct TrajectoryRecord {
+    std::uint32_t point = 0;                         ///< Material of the batch (sweep point)
+    std::uint32_t replica = 0;
+    std::uint64_t history = 0;
+    HistoryOutcome outcome = HistoryOutcome::Scaped;
+    std::array<double, 3> exitPosition;              ///< Final position
+    std::array<double, 3> exitVelocity;              ///< Final velocity
+    std::vector<std::array<double, 3>> trajectory;   ///< Positions along the history
+};
+
+/**
+ * @brief Writes recorded histories to disk from a dedicated thread.
+ *
+ * Transport workers hand their records over through a BoundedMpscQueue and go back to
+ * work; the writer thread drains the queue into a single file, so no file I/O happens
+ * in the transport loop. When the queue is full, push() yields until the writer has
+ * caught up.
+ *
+ * Each record is a header line followed by one "x y z" line per trajectory point:
+ *   history <point> <replica> <history> <outcome> <x> <y> <z> <vx> <vy> <vz> <points>
+ * Records appear in the order they finish, which depends on thread timing.
+ */
+class TrajectoryWriter {
+public:
+    /**
+     * @brief Opens the file and starts the writer thread.
+     *
+     * @param filename Output file
+     * @param capacity Records the queue can hold
+     * @throws std::runtime_error if the file cannot be created
+     */
+    explicit TrajectoryWriter(const std::string& filename, std::size_t capacity = 1024);
+
+    /// Calls close(), ignoring a write failure (close() reports it when called first)
+    ~TrajectoryWriter();
+
+    TrajectoryWriter(const TrajectoryWriter&) = delete;
+    TrajectoryWriter& operator=(const TrajectoryWriter&) = delete;
+
+    /// Queues a record (any thread); the record is moved from
+    void push(TrajectoryRecord& record);
+
+    /**
+     * @brief Writes everything still queued and stops the writer thread. No push() may follow.
+     *
+     * @throws std::runtime_error if any record could not be written (e.g. the disk is full)
+     */
+    void close();
+
+private:
+    std::string filename;
+    std::ofstream file;
+    BoundedMpscQueue<TrajectoryRecord> queue;
+    std::atomic<bool> closing;
+    std::thread writer;
+
+    void run();
+    void write(const TrajectoryRecord& record);
+};
+
+#endif // TRAJECTORYWRITER_HPP
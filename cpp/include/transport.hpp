@@ -0,0 +1,287 @@
+#ifndef TRANSPORT_HPP
+#define TRANSPORT_HPP
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "json.hpp"
+#include "basematerial.hpp"
+#include "cachealigned.hpp"
+#include "particle.hpp"
+#include "rng.hpp"
+#include "scheduler.hpp"
+
+using json = nlohmann::json;
+
+/**
+ * @brief Settings of a transport run, read once from the configuration.
+ */
+struct TransportSettings {
+    std::string particleType;            ///< "neutron" or "charged"
+    std::array<double, 3> position;      ///< Initial position of every particle
+    std::array<double, 3> velocity;      ///< Initial velocity of every particle
+    double charge = 0.0;                 ///< Charge (charged particles only)
+    double mass = 0.0;                   ///< Mass (charged particles only)
+    std::string shape;                   ///< Geometry name, as in MaterialFactory
+    std::int64_t numberSims = 0;         ///< Histories per replica
+    int replicas = 10;                   ///< Statistical replicas (run.replicas)
+    int threads = 1;                     ///< Worker threads of the history loop
+    int processes = 1;                   ///< Worker processes (see runTransportSharded)
+    bool pinThreads = false;             ///< Pin worker threads to CPUs (NUMA-local state)
+    int firstCpu = 0;                    ///< Pinning position of the first thread of this process
+    std::uint64_t seed = 0;              ///< Seed of the run
+    bool rqmc = false;                   ///< Randomized quasi-Monte Carlo sampler
+    bool saveHistories = false;          ///< Save one trajectory per outcome (replayed after the run)
+    int recordHistories = 0;             ///< Record the first histories of every replica during the run
+    std::string trajectoryFile;          ///< Output of the recorded histories (see TrajectoryWriter)
+    std::string outputDir;               ///< Directory for the trajectory files
+    std::string rngEngine = "philox";    ///< Engine behind the RandomGenerator
+    std::string transport = "event";     ///< "event" (EventTransport) or "analog" (transportHistory, reference)
+    int bankSize = 1024;                 ///< Particles in flight per thread in the event-based loop
+
+    /**
+     * @brief Reads the settings from a configuration already checked by
+     * MaterialFactory::validate_config.
+     *
+     * A missing or null run.seed is replaced by a random seed, and a missing or null
+     * run.replicas by 10. run.record_histories defaults to 0 (no recording) and
+     * run.bank_size to 1024.
+     */
+    static TransportSettings fromConfig(const json& config);
+};
+
+/// Fate of a single history
+enum class HistoryOutcome { Absorbed, Reflected, Scaped };
+
+/// @return Lower-case name of an outcome ("absorbed", "reflected", "scaped")
+const char* outcomeName(HistoryOutcome outcome);
+
+/**
+ * @brief Random-stream coordinates of a history.
+ *
+ * With the same seed, engine, sampler and geometry they regenerate the history
+ * exactly, so trajectories never need to be recorded during the run.
+ */
+struct HistoryRecord {
+    HistoryOutcome outcome;
+    std::uint32_t replica;
+    std::uint64_t history;
+};
+
+/// Number of histories per outcome whose coordinates are kept for replay
+const int kRepresentativesPerOutcome = 3;
+
+/// Fractions of each outcome, one entry per replica
+struct TransportResult {
+    std::vector<double> absorbedRatios;
+    std::vector<double> reflectedRatios;
+    std::vector<double> scapedRatios;
+    std::vector<HistoryRecord> representatives;  ///< First histories of each outcome
+    std::vector<WorkerStats> workerStats;        ///< Busy/idle time of each worker thread
+    double wallSeconds = 0.0;                    ///< Wall time of the loop that ran it (shared by a batch)
+};
+
+/**
+ * @brief Outcome counts and replay candidates of part of the histories of one replica.
+ *
+ * Every worker fills tallies of its own, merged once the loop is over. Each tally
+ * takes whole cache lines, so the counters of two workers never share one.
+ */
+struct alignas(kCacheLineSize) ReplicaTally {
+    std::int64_t NumAbsorbed = 0, NumReflected = 0, NumScaped = 0;
+    std::vector<HistoryRecord> representatives;  ///< First histories of each outcome in that part
+};
+
+/// Tallies of one worker, indexed by material * replicas + replica
+typedef std::vector<ReplicaTally, CacheAlignedAllocator<ReplicaTally>> TallyRow;
+
+/// Tallies of a batch of materials, indexed [worker][material * replicas + replica]
+typedef std::vector<TallyRow> BatchTallies;
+
+/**
+ * @brief Creates a particle at the initial conditions of the run.
+ *
+ * @throws std::runtime_error if the particle type is unknown
+ */
+std::unique_ptr<Particle> createParticle(const TransportSettings& settings);
+
+/**
+ * @brief Transports one particle until it is absorbed or leaves the material.
+ *
+ * @param particle Particle at its initial position
+ * @param material Material the particle moves through
+ * @param settings Settings of the run (geometry name for the reflection check)
+ * @param rng Random number context, already moved to the stream of the history
+ * @return Outcome of the history
+ */
+HistoryOutcome transportHistory(Particle& particle, const BaseMaterial& material,
+                                const TransportSettings& settings, RandomGenerator& rng);
+
+/// Same as above, adding the number of propagation steps of the history to steps
+HistoryOutcome transportHistory(Particle& particle, const BaseMaterial& material,
+                                const TransportSettings& settings, RandomGenerator& rng, std::int64_t& steps);
+
+/**
+ * @brief Runs all the replicas of a simulation with a given random engine.
+ *
+ * The histories of all replicas are shared among settings.threads workers by a
+ * WorkStealingScheduler. Each worker owns its generator, particles and counters; the
+ * counters are reduced in worker order after the join. Since every history has its
+ * own random stream, the result is identical for any number of threads and any
+ * split of the work.
+ *
+ * The engine is a compile-time policy (see rngengines.hpp); instantiated for
+ * PhiloxEngine, Xoshiro256ppEngine, Pcg64Engine and Mt19937_64Engine.
+ */
+template <typename Engine>
+TransportResult runTransport(const TransportSettings& settings, const BaseMaterial& material);
+
+/**
+ * @brief Number of histories in a batch of materials.
+ *
+ * The histories of a batch are numbered (material, replica, history), history fastest;
+ * transportBatch() runs any set of ranges of that index space.
+ */
+std::int64_t batchHistories(const TransportSettings& settings, size_t materials);
+
+/**
+ * @brief Measures the cost of one history of each material on a short pilot run.
+ *
+ * The pilot histories use a stream of their own, never part of the run.
+ *
+ * @param histories Pilot histories per material (at most settings.numberSims)
+ * @return Mean number of propagation steps per history plus one (the fixed cost of a
+ *         history), one entry per material
+ */
+std::vector<double> pilotHistoryCosts(const TransportSettings& settings,
+                                      const std::vector<const BaseMaterial*>& materials, int histories = 64);
+
+/**
+ * @brief Splits a batch into tasks of similar estimated cost.
+ *
+ * Materials whose histories cost far more than the average are split into several
+ * tasks, with a smaller grain; runs of cheap materials are merged into one task. With
+ * about eight tasks per worker, a sweep whose largest geometry costs a hundred times
+ * the smallest still starts evenly spread and finishes together.
+ *
+ * @param costs Cost of one history of each material (see pilotHistoryCosts)
+ * @param workers Total number of worker threads
+ * @return Tasks covering the whole batch, in index order
+ */
+std::vector<WorkTask> planBatch(const TransportSettings& settings, const std::vector<double>& costs, int workers);
+
+/**
+ * @brief Plans a batch: one pilot per material when there are several, uniform costs
+ * otherwise.
+ */
+std::vector<WorkTask> planBatch(const TransportSettings& settings, const std::vector<const BaseMaterial*>& materials,
+                                int workers);
+
+/**
+ * @brief Transports some tasks of a batch on settings.threads threads.
+ *
+ * Histories of index below settings.recordHistories are recorded to
+ * settings.trajectoryFile by a TrajectoryWriter.
+ *
+ * @param settings Settings of the run
+ * @param materials Materials of the batch
+ * @param tasks Ranges of the batch to run (see planBatch)
+ * @param stats Set to the accounting of each worker thread
+ * @return Tallies of every (material, replica) pair, one row per worker thread; pairs
+ *         outside the tasks are left empty
+ * @throws std::invalid_argument if the engine name is unknown
+ */
+BatchTallies transportBatch(const TransportSettings& settings, const std::vector<const BaseMaterial*>& materials,
+                            const std::vector<WorkTask>& tasks, std::vector<WorkerStats>& stats);
+
+/// Same as above, with the engine as a compile-time policy
+template <typename Engine>
+BatchTallies transportBatch(const TransportSettings& settings, const std::vector<const BaseMaterial*>& materials,
+                            const std::vector<WorkTask>& tasks, std::vector<WorkerStats>& stats);
+
+/**
+ * @brief Merges the tallies of every worker for one (material, replica) pair.
+ *
+ * Rows are combined pairwise in a fixed tree order ((0+1)+(2+3))+..., so the merge
+ * takes log2(workers) levels and its rounding, once tallies hold floating-point sums,
+ * does not depend on thread timing. The replay candidates of the result are sorted by
+ * history and cut to the first kRepresentativesPerOutcome of each outcome.
+ *
+ * @param tallies Tallies of a batch, one row per worker
+ * @param slot Index of the pair, material * replicas + replica
+ */
+ReplicaTally mergeTallies(const BatchTallies& tallies, int slot);
+
+/**
+ * @brief Merges the tallies of a batch into one result per material.
+ *
+ * Each replica is merged with mergeTallies, so the result only depends on which
+ * histories were run, not on how they were split.
+ */
+std::vector<TransportResult> reduceBatch(const TransportSettings& settings, size_t materials,
+                                         const BatchTallies& tallies);
+
+/**
+ * @brief Runs all the replicas with the engine named in settings.rngEngine.
+ *
+ * @throws std::invalid_argument if the engine name is unknown
+ */
+TransportResult runTransport(const TransportSettings& settings, const BaseMaterial& material);
+
+/**
+ * @brief Runs all the replicas for several materials on one pool of workers.
+ *
+ * The histories of every material share the scheduler, so a batch finishes as soon as
+ * the total work allows rather than point by point. Each material gets the same
+ * streams as a separate runTransport call. The batch is split by planBatch, so
+ * expensive materials are spread over more tasks. The workerStats of every result are
+ * those of the whole batch. With settings.processes > 1 the batch is handed to
+ * runTransportSharded.
+ *
+ * @param materials Materials to run, all of settings.shape
+ * @return One result per material, in the same order
+ * @throws std::invalid_argument if the engine name is unknown
+ */
+std::vector<TransportResult> runTransport(const TransportSettings& settings,
+                                          const std::vector<const BaseMaterial*>& materials);
+
+/// Same as above, with the engine as a compile-time policy
+template <typename Engine>
+std::vector<TransportResult> runTransport(const TransportSettings& settings,
+                                          const std::vector<const BaseMaterial*>& materials);
+
+/**
+ * @brief Creates a generator backed by the named engine.
+ *
+ * @throws std::invalid_argument if the engine name is unknown
+ */
+std::unique_ptr<RandomGenerator> createRandomGenerator(const std::string& engine, std::uint64_t seed);
+
+/**
+ * @brief Regenerates a single history and records its trajectory.
+ *
+ * @param settings Settings of the original run (seed, engine and sampler must match)
+ * @param material Material of the original run
+ * @param replica Replica of the history
+ * @param history Index of the history inside the replica
+ * @param outcome Set to the outcome of the history
+ * @return The particle, with its full trajectory
+ */
+std::unique_ptr<Particle> replayHistory(const TransportSettings& settings, const BaseMaterial& material,
+                                        std::uint32_t replica, std::uint64_t history,
+                                        HistoryOutcome& outcome);
+
+/**
+ * @brief Writes the trajectory files and the replay index of a run.
+ *
+ * Replays the first representative of each outcome into hist_<outcome>.txt and lists
+ * all representatives in replay_index.txt, in settings.outputDir.
+ *
+ * @param scale Geometry size of the run, recorded in the index
+ */
+void saveRepresentativeHistories(const TransportSettings& settings, const BaseMaterial& material,
+                                 const TransportResult& result, double scale);
+
+#endif // TRANSPORT_HPP
@@ -0,0 +1,60 @@
+#ifndef ZIGGURAT_HPP
+#define ZIGGURAT_HPP
+
+#include <cmath>
+#include <cstdint>
+
+/**
+ * @brief Ziggurat sampler for the unit-mean exponential distribution.
+ *
+ * Marsaglia & Tsang (2000) with 256 layers. About 98.9% of the draws are accepted by
+ * a table lookup, one multiplication and one comparison, so free-flight distances no
+ * longer pay for a log each. The tables are built once, the first time instance() is
+ * called.
+ */
+class ExponentialZiggurat {
+public:
+    /// @return The sampler with its tables, built on first use
+    static const ExponentialZiggurat& instance();
+
+    /**
+     * @brief Draws one exponential variate with unit mean.
+     *
+     * @param nextBits Callable returning 64 random bits; called once in the common case
+     * @return Sample of Exp(1)
+     */
+    template <typename BitSource>
+    double sample(BitSource& nextBits) const {
+        for (;;) {
+            const std::uint64_t bits = nextBits();
+            const int i = static_cast<int>(bits & 0xFF);
+            const std::uint64_t r = bits >> 11;
+            const double x = r * w[i];
+            if (r < k[i]) return x;
+
+            if (i == 0) {
+                // Tail beyond the base layer: the exponential is memoryless
+                return kR - std::log(1.0 - toUniform(nextBits()));
+            }
+            if (f[i] + toUniform(nextBits()) * (f[i - 1] - f[i]) < std::exp(-x)) {
+                return x;
+            }
+        }
+    }
+
+private:
+    static constexpr double kR = 7.69711747013104972;     ///< Start of the tail
+    static constexpr double kV = 3.949659822581572e-3;    ///< Area of each layer
+
+    std::uint64_t k[256];  ///< Acceptance thresholds on the 53-bit draw
+    double w[256];         ///< Scale from the 53-bit draw to x
+    double f[256];         ///< exp(-x) at the layer edges
+
+    ExponentialZiggurat();
+
+    static double toUniform(std::uint64_t bits) {
+        return (bits >> 11) * (1.0 / 9007199254740992.0);
+    }
+};
+
+#endif // ZIGGURAT_HPP
@@ -1,13 +1,18 @@
-#include "neutron.hpp"
-#include "chargedparticle.hpp"
 #include "basematerial.hpp"
 #include "materialfactory.hpp"
+#include "transport.hpp"
+#include "rngengines.hpp"
+#include "sweep.hpp"
+#include "grid.hpp"
 #include <iostream>
 #include <fstream>
-#include <random>
 #include <cmath>
 #include <vector>
 #include <string>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
 
 // Computes the mean of a vector of doubles
 double compute_mean(const std::vector<double>& values) {
@@ -23,15 +28,130 @@ double compute_stddev(const std::vector<double>& values, double mean) {
     return std::sqrt(sum / values.size());
 }
 
+// Prints mean and standard deviation of each outcome on one line
+void print_statistics(std::ostream& out, const TransportResult& result) {
+    double mean_abs = compute_mean(result.absorbedRatios);
+    double stddev_abs = compute_stddev(result.absorbedRatios, mean_abs);
+    double mean_ref = compute_mean(result.reflectedRatios);
+    double stddev_ref = compute_stddev(result.reflectedRatios, mean_ref);
+    double mean_sc = compute_mean(result.scapedRatios);
+    double stddev_sc = compute_stddev(result.scapedRatios, mean_sc);
+
+    out << mean_abs << " " << stddev_abs << " "
+        << mean_ref << " " << stddev_ref << " "
+        << mean_sc << " " << stddev_sc << std::endl;
+}
+
+// Prints the busy/idle time of each worker thread (or process, with --workers) to stderr,
+// and the histories per second of each NUMA node when the workers are pinned
+void print_worker_stats(const TransportResult& result) {
+    double busy = 0.0, wall = 0.0;
+    std::map<int, long long> node_histories;
+    std::fprintf(stderr, "worker cpu node busy(s) idle(s) histories chunks steals\n");
+    for (size_t t = 0; t < result.workerStats.size(); t++) {
+        const WorkerStats& stats = result.workerStats[t];
+        std::fprintf(stderr, "%zu %d %d %.3f %.3f %lld %lld %lld\n", t, stats.cpu, stats.node,
+                     stats.busySeconds, stats.idleSeconds,
+                     static_cast<long long>(stats.items), static_cast<long long>(stats.chunks),
+                     static_cast<long long>(stats.steals));
+        busy += stats.busySeconds;
+        wall = std::max(wall, stats.busySeconds + stats.idleSeconds);
+        node_histories[stats.node] += stats.items;
+    }
+    // Measured wall time of the loop; the longest worker when the loop did not record it
+    if (result.wallSeconds > 0.0) wall = result.wallSeconds;
+    if (wall > 0.0) {
+        std::fprintf(stderr, "parallel efficiency %.1f%%\n", 100.0 * busy / (wall * result.workerStats.size()));
+        for (const auto& node : node_histories) {
+            if (node.first < 0) continue;
+            std::fprintf(stderr, "node %d: %.0f histories/s\n", node.first, node.second / wall);
+        }
+    }
+}
+
 int main(int argc, char* argv[]) {
+    // Positional arguments (config file and scale), optionally followed by options
+    std::vector<std::string> positional;
+    std::string rng_engine = rngEngineNames().front();
+    std::string transport_mode = "event";
+    bool sweep = false;
+    double min_scale = 0.0, max_scale = 0.0;
+    int sweep_points = 0;
+    bool grid = false;
+    bool replay = false;
+    std::uint64_t replay_id = 0;
+    bool seed_override = false;
+    std::uint64_t seed = 0;
+    int threads = 1;
+    int workers = 1;
+    bool pin_threads = false;
+    bool thread_stats = false;
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        if (arg == "--rng" && a + 1 < argc) {
+            rng_engine = argv[++a];
+        } else if (arg == "--transport" && a + 1 < argc) {
+            transport_mode = argv[++a];
+        } else if (arg == "--replay" && a + 1 < argc) {
+            replay = true;
+            replay_id = std::strtoull(argv[++a], nullptr, 10);
+        } else if (arg == "--seed" && a + 1 < argc) {
+            seed_override = true;
+            seed = std::strtoull(argv[++a], nullptr, 10);
+        } else if (arg == "--threads" && a + 1 < argc) {
+            threads = std::atoi(argv[++a]);
+        } else if (arg == "--workers" && a + 1 < argc) {
+            workers = std::atoi(argv[++a]);
+        } else if (arg == "--pin") {
+            pin_threads = true;
+        } else if (arg == "--thread-stats") {
+            thread_stats = true;
+        } else if (arg == "--grid") {
+            grid = true;
+        } else if (arg == "--sweep" && a + 3 < argc) {
+            sweep = true;
+            min_scale = std::atof(argv[++a]);
+            max_scale = std::atof(argv[++a]);
+            sweep_points = std::atoi(argv[++a]);
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
     // Ensure correct number of command-line arguments
-    if (argc != 3) {
-        std::cerr << "Usage: " << argv[0] << " <config_file.json> <scale>\n";
+    if (positional.size() != ((sweep || grid) ? 1u : 2u) || (sweep && replay) || (grid && (sweep || replay))) {
+        std::cerr << "Usage: " << argv[0] << " <config_file.json> <scale> [--rng <engine>] [--transport <mode>] [--seed <seed>] [--threads <n>] [--workers <n>] [--pin] [--thread-stats]\n"
+                  << "       " << argv[0] << " <config_file.json> --sweep <min_scale> <max_scale> <points> [--rng <engine>] [--transport <mode>] [--seed <seed>] [--threads <n>] [--workers <n>] [--pin]\n"
+                  << "       " << argv[0] << " <config_file.json> --grid [--rng <engine>] [--transport <mode>] [--seed <seed>] [--threads <n>] [--workers <n>] [--pin]\n"
+                  << "       " << argv[0] << " <config_file.json> <scale> --replay <history_id> [--rng <engine>] [--seed <seed>]\n";
+        return 1;
+    }
+
+    if (sweep && (sweep_points < 2 || min_scale > max_scale)) {
+        std::cerr << "Error: --sweep needs min_scale <= max_scale and at least 2 points\n";
+        return 1;
+    }
+
+    if (threads < 1 || workers < 1) {
+        std::cerr << "Error: --threads and --workers need at least 1\n";
+        return 1;
+    }
+
+    if (transport_mode != "event" && transport_mode != "analog") {
+        std::cerr << "Error: Unknown transport mode '" << transport_mode << "'. Available: event analog\n";
+        return 1;
+    }
+
+    std::vector<std::string> engines = rngEngineNames();
+    if (std::find(engines.begin(), engines.end(), rng_engine) == engines.end()) {
+        std::cerr << "Error: Unknown random engine '" << rng_engine << "'. Available:";
+        for (const auto& name : engines) std::cerr << " " << name;
+        std::cerr << "\n";
         return 1;
     }
 
     // Open the configuration file
-    std::ifstream config_file(argv[1]);
+    std::ifstream config_file(positional[0]);
     if (!config_file) {
         std::cerr << "Error: Could not open config file.\n";
         return 1;
@@ -56,145 +176,167 @@ int main(int argc, char* argv[]) {
     }
 
     // Read simulation settings from the configuration
-    int NumberSims = config["run"]["simulations"];
-    std::string run_name = config["run"]["run_name"];
-    std::string shape = config["geometry"]["shape"];
-    double length = std::atof(argv[2]);  // Scale factor passed via command line
-    bool save_histories = config["run"].contains("save_hist");  // Optional history saving
+    TransportSettings settings = TransportSettings::fromConfig(config);
+    settings.rngEngine = rng_engine;
+    settings.transport = transport_mode;
+    settings.threads = threads;
+    settings.processes = workers;
+    settings.pinThreads = pin_threads;
+    if (seed_override) {
+        settings.seed = seed;
+    }
 
-    // Create output directory
-    std::__fs::filesystem::create_directories("../out/" + run_name + "/data");
-
-    // Vectors to accumulate outcome ratios across multiple runs
-    std::vector<double> absorbed_ratios, reflected_ratios, scaped_ratios;
-    bool saved_absorbed = false, saved_reflected = false, saved_scaped = false;
-
-    // Initial particle conditions
-    double x0 = config["particle"]["x"];
-    double y0 = config["particle"]["y"];
-    double z0 = config["particle"]["z"];
-    double vx = config["particle"]["vx"];
-    double vy = config["particle"]["vy"];
-    double vz = config["particle"]["vz"];
-    std::string particle_type = config["particle"]["type"];
-
-    // Charge and mass are only relevant for charged particles
-    double charge = 0.0;
-    double mass = 0.0;
-    if (particle_type == "charged") {
-        charge = config["particle"]["charge"];
-        mass = config["particle"]["mass"];
-    }
-
-    // Create material object based on configuration
-    std::unique_ptr<BaseMaterial> material;
-    try {
-        bool isCharged = (particle_type == "charged");
-        material = configuration.createMaterial(config, shape, length, isCharged);
-    } catch (const std::exception& e) {
-        std::cerr << "Error creating material: " << e.what() << std::endl;
+    // Scale factors: passed via command line, or the points of the sweep (grids carry their own)
+    std::vector<double> scales;
+    if (sweep) {
+        scales = sweepScales(min_scale, max_scale, sweep_points);
+    } else if (!grid) {
+        scales.push_back(std::atof(positional[1].c_str()));
+    }
+
+    if (settings.particleType != "neutron" && settings.particleType != "charged") {
+        std::cerr << "ERROR: Unknown particle type '" << settings.particleType << "'\n";
         return 1;
     }
 
-    // Run the simulation multiple times to get statistics
-    for (int run = 0; run < 10; run++) {
-        int NumAbsorbed = 0, NumReflected = 0, NumScaped = 0;
-
-        for (int i = 0; i < NumberSims; i++) {
-            // Create a new particle based on type
-            std::unique_ptr<Particle> particle;
-            if (particle_type == "neutron") {
-                particle = std::make_unique<Neutron>(x0, y0, z0, vx, vy, vz);
-            } else if (particle_type == "charged") {
-                particle = std::make_unique<ChargedParticle>(x0, y0, z0, vx, vy, vz, charge, mass);
-            } else {
-                std::cerr << "ERROR: Unknown particle type '" << particle_type << "'\n";
-                return 1;
-            }
+    // Create output directory
+    std::__fs::filesystem::create_directories(settings.outputDir);
 
-            // Ensure the particle starts within bounds
-            if (!material->isWithinBounds(*particle)) {
-                std::cerr << "ERROR. The particle starts outside the material." << std::endl;
-                return 2;
-            }
+    if (grid) {
+        ConfigError grid_error;
+        if (!config.contains("grid")) {
+            grid_error.add_error("Error: --grid needs a 'grid' section in the configuration");
+        } else {
+            validateGrid(config, grid_error);
+        }
+        if (grid_error.has_errors()) {
+            grid_error.print_errors();
+            return 1;
+        }
 
-            bool absorbed = false;
-            bool reflected = false;
-
-            double xinit = 0.0;
-            // For slab geometries, get the initial x-boundary for later reflection check
-            if (shape == "regular_slab") {
-                if (const RegularSlab* slabPtr = dynamic_cast<const RegularSlab*>(material.get())) {
-                    xinit = slabPtr->getXInit();
-                }
-            } else if (shape == "double_slab") { 
-                if (const DoubleSlab* slabPtr = dynamic_cast<const DoubleSlab*>(material.get())) {
-                    xinit = slabPtr->getXInit();
-                }
-            }
+        std::vector<GridPoint> points;
+        try {
+            points = runGrid(config, settings);
+        } catch (const std::exception& e) {
+            std::cerr << "ERROR. " << e.what() << std::endl;
+            return 2;
+        }
 
-            // First propagation before checking absorption
-            particle->appendHistory();
-            
-            particle->propagate(*material);
-
-            // Particle loop: propagate until out of bounds or absorbed
-            while (material->isWithinBounds(*particle)) {
-                if (particle->getAbsorption(*material)) {
-                    absorbed = true;
-                    break;
-                }
-                particle->propagate(*material);
+        // One line per parameter tuple, to stdout and to grid_output.txt
+        std::string table_name = settings.outputDir + "/grid_output.txt";
+        std::ofstream table(table_name);
+        if (!table) {
+            std::cerr << "Error: Could not create " << table_name << "\n";
+            return 1;
+        }
+        for (const GridAxis& axis : gridAxes(config)) table << axis.name() << " ";
+        table << "Absorbed std Reflected std Scaped std\n";
+        for (const GridPoint& point : points) {
+            for (double value : point.job.values) {
+                std::cout << value << " ";
+                table << value << " ";
             }
+            print_statistics(std::cout, point.result);
+            print_statistics(table, point.result);
+        }
+        if (thread_stats) print_worker_stats(points.front().result);
+        return 0;
+    }
 
-            // Check if the particle was reflected (escaped through the entry side)
-            if (!absorbed && (shape == "regular_slab" || shape == "double_slab")) {
-                double x = particle->getPosition()[0];
-                if (x < xinit) {
-                    reflected = true;
-                }
-            }
+    // Create one material per geometry size based on configuration and ensure the particle starts within bounds
+    std::vector<std::unique_ptr<BaseMaterial>> owned;
+    std::vector<const BaseMaterial*> materials;
+    for (double length : scales) {
+        try {
+            bool isCharged = (settings.particleType == "charged");
+            owned.push_back(configuration.createMaterial(config, settings.shape, length, isCharged));
+        } catch (const std::exception& e) {
+            std::cerr << "Error creating material: " << e.what() << std::endl;
+            return 1;
+        }
 
-            // Record final state of the particle
-            if (absorbed) NumAbsorbed++;
-            else if (reflected) NumReflected++;
-            else NumScaped++;
-
-            // Optionally save particle history if required
-            if (save_histories) {
-                if (absorbed && !saved_absorbed) {
-                    particle->saveHistoryToFile("../out/" + run_name + "/data/hist_absorbed.txt");
-                    saved_absorbed = true;
-                } 
-                else if (reflected && !saved_reflected) {
-                    particle->saveHistoryToFile("../out/" + run_name + "/data/hist_reflected.txt");
-                    saved_reflected = true;
-                } 
-                else if (!reflected && !absorbed && !saved_scaped) {
-                    particle->saveHistoryToFile("../out/" + run_name + "/data/hist_scaped.txt");
-                    saved_scaped = true;
-                }
-            }
+        if (!owned.back()->isWithinBounds(*createParticle(settings))) {
+            std::cerr << "ERROR. The particle starts outside the material." << std::endl;
+            return 2;
         }
+        materials.push_back(owned.back().get());
+    }
+    const BaseMaterial& material = *materials.back();
 
-        // Store results from this run
-        absorbed_ratios.push_back(static_cast<double>(NumAbsorbed) / NumberSims);
-        reflected_ratios.push_back(static_cast<double>(NumReflected) / NumberSims);
-        scaped_ratios.push_back(static_cast<double>(NumScaped) / NumberSims);
+    if (replay) {
+        // Regenerate a single history from its random-stream coordinates (see replay_index.txt).
+        // A fresh random seed would regenerate some other history.
+        if (!seed_override && !(config["run"].contains("seed") && !config["run"]["seed"].is_null())) {
+            std::cerr << "Error: --replay needs the seed of the run: set run.seed or pass --seed "
+                         "(see replay_index.txt)\n";
+            return 1;
+        }
+        std::uint64_t total = static_cast<std::uint64_t>(settings.numberSims) * settings.replicas;
+        if (replay_id >= total) {
+            std::cerr << "Error: history id must be smaller than " << total << "\n";
+            return 1;
+        }
+        std::uint32_t replica = static_cast<std::uint32_t>(replay_id / settings.numberSims);
+        std::uint64_t history = replay_id % settings.numberSims;
+
+        HistoryOutcome outcome;
+        std::unique_ptr<Particle> particle = replayHistory(settings, material, replica, history, outcome);
+        std::string filename = settings.outputDir + "/hist_replay_" + std::to_string(replay_id) + ".txt";
+        particle->saveHistoryToFile(filename);
+        std::cout << outcomeName(outcome) << " " << filename << std::endl;
+        return 0;
+    }
+
+    if (sweep) {
+        // All points share the seed, so they are sampled with common random numbers
+        std::vector<SweepPoint> points;
+        try {
+            points = runSweep(settings, scales, materials);
+        } catch (const std::exception& e) {
+            std::cerr << "ERROR. " << e.what() << std::endl;
+            return 2;
+        }
+
+        // One line per geometry size, to stdout and to simulations_output.txt
+        std::string table_name = settings.outputDir + "/simulations_output.txt";
+        std::ofstream table(table_name);
+        if (!table) {
+            std::cerr << "Error: Could not create " << table_name << "\n";
+            return 1;
+        }
+        table << "Scale Absorbed std Reflected std Scaped std\n";
+        for (const SweepPoint& point : points) {
+            char scale[32];
+            std::snprintf(scale, sizeof(scale), "%.2f ", point.scale);
+            std::cout << scale;
+            print_statistics(std::cout, point.result);
+            table << scale;
+            print_statistics(table, point.result);
+        }
+        if (thread_stats) print_worker_stats(points.front().result);
+
+        // Trajectories of the last geometry size, as when each size was a separate run
+        if (settings.saveHistories) {
+            saveRepresentativeHistories(settings, material, points.back().result, points.back().scale);
+        }
+        return 0;
     }
 
-    // Compute final statistics: mean and standard deviation for each outcome
-    double mean_abs = compute_mean(absorbed_ratios);
-    double stddev_abs = compute_stddev(absorbed_ratios, mean_abs);
-    double mean_ref = compute_mean(reflected_ratios);
-    double stddev_ref = compute_stddev(reflected_ratios, mean_ref);
-    double mean_sc = compute_mean(scaped_ratios);
-    double stddev_sc = compute_stddev(scaped_ratios, mean_sc);
+    // Run the simulation multiple times to get statistics and output them
+    TransportResult result;
+    try {
+        result = runTransport(settings, material);
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR. " << e.what() << std::endl;
+        return 2;
+    }
+    print_statistics(std::cout, result);
+    if (thread_stats) print_worker_stats(result);
 
-    // Output the statistics
-    std::cout << mean_abs << " " << stddev_abs << " "
-              << mean_ref << " " << stddev_ref << " "
-              << mean_sc << " " << stddev_sc << std::endl;
+    // Trajectories are not recorded during the run: representative histories are replayed
+    if (settings.saveHistories) {
+        saveRepresentativeHistories(settings, material, result, scales.front());
+    }
 
     return 0;
 }
@@ -0,0 +1,187 @@
+#include "boundscheck.hpp"
+#include "simd.hpp"
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BOUNDS_HAVE_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// The scalar loops also finish the SIMD kernels; kept out of line so they are never
+// compiled for a target with FMA, which could fuse x*x + y*y
+__attribute__((noinline))
+void intervalScalar(const double* x, double lo, double hi, std::uint8_t* inside, int n) {
+    for (int i = 0; i < n; ++i) {
+        inside[i] = x[i] >= lo && x[i] <= hi;
+    }
+}
+
+__attribute__((noinline))
+void boxScalar(const double* x, const double* y, const double* z,
+               const std::array<double, 3>& lo, const std::array<double, 3>& hi, std::uint8_t* inside, int n) {
+    for (int i = 0; i < n; ++i) {
+        inside[i] = x[i] >= lo[0] && x[i] <= hi[0] && y[i] >= lo[1] && y[i] <= hi[1] && z[i] >= lo[2] && z[i] <= hi[2];
+    }
+}
+
+__attribute__((noinline))
+void ballScalar(const double* x, const double* y, const double* z, double radius, std::uint8_t* inside, int n) {
+    for (int i = 0; i < n; ++i) {
+        inside[i] = std::sqrt(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]) <= radius;
+    }
+}
+
+#ifdef BOUNDS_HAVE_SIMD
+
+// Bytes 0/1 of each 4-bit comparison mask, lowest bit first
+const std::uint32_t kMaskBytes[16] = {
+    0x00000000, 0x00000001, 0x00000100, 0x00000101, 0x00010000, 0x00010001, 0x00010100, 0x00010101,
+    0x01000000, 0x01000001, 0x01000100, 0x01000101, 0x01010000, 0x01010001, 0x01010100, 0x01010101,
+};
+
+inline void storeMask4(unsigned mask, std::uint8_t* inside) {
+    std::memcpy(inside, &kMaskBytes[mask & 15], 4);
+}
+
+// Ordered comparisons, so a NaN coordinate is outside as in the scalar code
+__attribute__((target("avx2")))
+void intervalAvx2(const double* x, double lo, double hi, std::uint8_t* inside, int n) {
+    const __m256d vlo = _mm256_set1_pd(lo);
+    const __m256d vhi = _mm256_set1_pd(hi);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d vx = _mm256_loadu_pd(x + i);
+        const __m256d in = _mm256_and_pd(_mm256_cmp_pd(vx, vlo, _CMP_GE_OQ), _mm256_cmp_pd(vx, vhi, _CMP_LE_OQ));
+        storeMask4(_mm256_movemask_pd(in), inside + i);
+    }
+    intervalScalar(x + i, lo, hi, inside + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void boxAvx2(const double* x, const double* y, const double* z,
+             const std::array<double, 3>& lo, const std::array<double, 3>& hi, std::uint8_t* inside, int n) {
+    const __m256d loX = _mm256_set1_pd(lo[0]), hiX = _mm256_set1_pd(hi[0]);
+    const __m256d loY = _mm256_set1_pd(lo[1]), hiY = _mm256_set1_pd(hi[1]);
+    const __m256d loZ = _mm256_set1_pd(lo[2]), hiZ = _mm256_set1_pd(hi[2]);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d vx = _mm256_loadu_pd(x + i);
+        const __m256d vy = _mm256_loadu_pd(y + i);
+        const __m256d vz = _mm256_loadu_pd(z + i);
+        __m256d in = _mm256_and_pd(_mm256_cmp_pd(vx, loX, _CMP_GE_OQ), _mm256_cmp_pd(vx, hiX, _CMP_LE_OQ));
+        in = _mm256_and_pd(in, _mm256_and_pd(_mm256_cmp_pd(vy, loY, _CMP_GE_OQ), _mm256_cmp_pd(vy, hiY, _CMP_LE_OQ)));
+        in = _mm256_and_pd(in, _mm256_and_pd(_mm256_cmp_pd(vz, loZ, _CMP_GE_OQ), _mm256_cmp_pd(vz, hiZ, _CMP_LE_OQ)));
+        storeMask4(_mm256_movemask_pd(in), inside + i);
+    }
+    boxScalar(x + i, y + i, z + i, lo, hi, inside + i, n - i);
+}
+
+// Separate multiplies and adds in the scalar order: no FMA, so the distance rounds
+// exactly as in Sphere::contains
+__attribute__((target("avx2")))
+void ballAvx2(const double* x, const double* y, const double* z, double radius, std::uint8_t* inside, int n) {
+    const __m256d vr = _mm256_set1_pd(radius);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d vx = _mm256_loadu_pd(x + i);
+        const __m256d vy = _mm256_loadu_pd(y + i);
+        const __m256d vz = _mm256_loadu_pd(z + i);
+        const __m256d d2 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(vx, vx), _mm256_mul_pd(vy, vy)), _mm256_mul_pd(vz, vz));
+        storeMask4(_mm256_movemask_pd(_mm256_cmp_pd(_mm256_sqrt_pd(d2), vr, _CMP_LE_OQ)), inside + i);
+    }
+    ballScalar(x + i, y + i, z + i, radius, inside + i, n - i);
+}
+
+// AVX-512 implies FMA, and GCC fuses plain _mm512_mul_pd/_mm512_add_pd; the explicit
+// rounding forms are never fused (zero-masked, as the unmasked ones start from an
+// undefined register)
+const int kRound = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
+
+__attribute__((target("avx512f")))
+inline __m512d mul(__m512d a, __m512d b) { return _mm512_maskz_mul_round_pd(0xFF, a, b, kRound); }
+
+__attribute__((target("avx512f")))
+inline __m512d add(__m512d a, __m512d b) { return _mm512_maskz_add_round_pd(0xFF, a, b, kRound); }
+
+inline void storeMask8(unsigned mask, std::uint8_t* inside) {
+    storeMask4(mask, inside);
+    storeMask4(mask >> 4, inside + 4);
+}
+
+__attribute__((target("avx512f")))
+void intervalAvx512(const double* x, double lo, double hi, std::uint8_t* inside, int n) {
+    const __m512d vlo = _mm512_set1_pd(lo);
+    const __m512d vhi = _mm512_set1_pd(hi);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m512d vx = _mm512_loadu_pd(x + i);
+        const __mmask8 in = _mm512_cmp_pd_mask(vx, vlo, _CMP_GE_OQ) & _mm512_cmp_pd_mask(vx, vhi, _CMP_LE_OQ);
+        storeMask8(in, inside + i);
+    }
+    intervalScalar(x + i, lo, hi, inside + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+void boxAvx512(const double* x, const double* y, const double* z,
+               const std::array<double, 3>& lo, const std::array<double, 3>& hi, std::uint8_t* inside, int n) {
+    const __m512d loX = _mm512_set1_pd(lo[0]), hiX = _mm512_set1_pd(hi[0]);
+    const __m512d loY = _mm512_set1_pd(lo[1]), hiY = _mm512_set1_pd(hi[1]);
+    const __m512d loZ = _mm512_set1_pd(lo[2]), hiZ = _mm512_set1_pd(hi[2]);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m512d vx = _mm512_loadu_pd(x + i);
+        const __m512d vy = _mm512_loadu_pd(y + i);
+        const __m512d vz = _mm512_loadu_pd(z + i);
+        const __mmask8 in = _mm512_cmp_pd_mask(vx, loX, _CMP_GE_OQ) & _mm512_cmp_pd_mask(vx, hiX, _CMP_LE_OQ) &
+                            _mm512_cmp_pd_mask(vy, loY, _CMP_GE_OQ) & _mm512_cmp_pd_mask(vy, hiY, _CMP_LE_OQ) &
+                            _mm512_cmp_pd_mask(vz, loZ, _CMP_GE_OQ) & _mm512_cmp_pd_mask(vz, hiZ, _CMP_LE_OQ);
+        storeMask8(in, inside + i);
+    }
+    boxScalar(x + i, y + i, z + i, lo, hi, inside + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+void ballAvx512(const double* x, const double* y, const double* z, double radius, std::uint8_t* inside, int n) {
+    const __m512d vr = _mm512_set1_pd(radius);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m512d vx = _mm512_loadu_pd(x + i);
+        const __m512d vy = _mm512_loadu_pd(y + i);
+        const __m512d vz = _mm512_loadu_pd(z + i);
+        const __m512d d2 = add(add(mul(vx, vx), mul(vy, vy)), mul(vz, vz));
+        storeMask8(_mm512_cmp_pd_mask(_mm512_maskz_sqrt_round_pd(0xFF, d2, kRound), vr, _CMP_LE_OQ), inside + i);
+    }
+    ballScalar(x + i, y + i, z + i, radius, inside + i, n - i);
+}
+
+#endif
+
+}
+
+void BoundsCheck::interval(const double* x, double lo, double hi, std::uint8_t* inside, int n) {
+#ifdef BOUNDS_HAVE_SIMD
+    if (simdLevel() == SimdLevel::Avx512) return intervalAvx512(x, lo, hi, inside, n);
+    if (simdLevel() == SimdLevel::Avx2) return intervalAvx2(x, lo, hi, inside, n);
+#endif
+    intervalScalar(x, lo, hi, inside, n);
+}
+
+void BoundsCheck::box(const double* x, const double* y, const double* z,
+                      const std::array<double, 3>& lo, const std::array<double, 3>& hi, std::uint8_t* inside, int n) {
+#ifdef BOUNDS_HAVE_SIMD
+    if (simdLevel() == SimdLevel::Avx512) return boxAvx512(x, y, z, lo, hi, inside, n);
+    if (simdLevel() == SimdLevel::Avx2) return boxAvx2(x, y, z, lo, hi, inside, n);
+#endif
+    boxScalar(x, y, z, lo, hi, inside, n);
+}
+
+void BoundsCheck::ball(const double* x, const double* y, const double* z, double radius, std::uint8_t* inside, int n) {
+#ifdef BOUNDS_HAVE_SIMD
+    if (simdLevel() == SimdLevel::Avx512) return ballAvx512(x, y, z, radius, inside, n);
+    if (simdLevel() == SimdLevel::Avx2) return ballAvx2(x, y, z, radius, inside, n);
+#endif
+    ballScalar(x, y, z, radius, inside, n);
+}
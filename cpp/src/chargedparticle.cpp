@@ -1,6 +1,6 @@
 #include "chargedparticle.hpp"
 #include "doubleslab.hpp"
-#include <random>
+#include "elasticscatter.hpp"
 #include <cmath>
 #include "iostream"
 
@@ -10,32 +10,15 @@ ChargedParticle::ChargedParticle(double x, double y, double z,
     : Particle(x, y, z, vx, vy, vz), charge(charge_), mass(mass_), is_absorbed(false)
 {}
 
-double ChargedParticle::getRandomStepLength(const BaseMaterial&  material) {
-    std::random_device rd;  
-    std::mt19937 gen(rd()); 
-
-    int min = 0, max = 1;
-    std::uniform_real_distribution<> distrib(min, max);
-
-    return - material.getLambda(*this) * log(distrib(gen));
+double ChargedParticle::getRandomStepLength(const BaseMaterial&  material, RandomGenerator& rng) {
+    return material.getLambda(*this) * rng.exponential();
 }
 
-std::array<double, 3> ChargedParticle::getThermalStep(const BaseMaterial& material) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<> distrib(0.0, 1.0);
-
-    auto r = getRandomStepLength(material);
-
-    auto angles = getRandomSphericalCoordinates();
-    double phi = angles.first;
-    double theta = angles.second;
+std::array<double, 3> ChargedParticle::getThermalStep(const BaseMaterial& material, RandomGenerator& rng) {
+    auto r = getRandomStepLength(material, rng);
+    auto direction = sampleIsotropicDirection(rng);
 
-    double dx = r * sin(theta) * cos(phi);
-    double dy = r * sin(theta) * sin(phi);
-    double dz = r * cos(theta);
-
-    return {dx, dy, dz};
+    return {r * direction[0], r * direction[1], r * direction[2]};
 }
 
 void ChargedParticle::applyEnergyLoss(const BaseMaterial& material, double stepLength) {
@@ -68,21 +51,17 @@ void ChargedParticle::applyDragForce(const BaseMaterial& material) {
     }
 }
 
-bool ChargedParticle::getAbsorption(const BaseMaterial& material) const {
+bool ChargedParticle::getAbsorption(const BaseMaterial& material, RandomGenerator& rng) const {
     if (is_absorbed) return true;
 
-    std::random_device rd;  
-    std::mt19937 gen(rd()); 
-    std::uniform_real_distribution<> distrib(0.0, 1.0);
-
-    return distrib(gen) < material.getPabs(*this);
+    return rng.uniform() < material.getPabs(*this);
 }
 
 bool ChargedParticle::isAbsorbed() const {
     return is_absorbed;
 }
 
-void ChargedParticle::elasticScatter(const BaseMaterial& material) {
+void ChargedParticle::elasticScatter(const BaseMaterial& material, RandomGenerator& rng) {
     double A = material.getAtomicMass(*this);
     if (A <= 0) return;
 
@@ -90,45 +69,20 @@ void ChargedParticle::elasticScatter(const BaseMaterial& material) {
     double v_initial = std::sqrt(vx*vx + vy*vy + vz*vz);
     if (v_initial == 0.0) return;
 
-    double v_cm_x = (mass * vx) / (mass + A);
-    double v_cm_y = (mass * vy) / (mass + A);
-    double v_cm_z = (mass * vz) / (mass + A);
-
-    double v_rel_x = vx - v_cm_x;
-    double v_rel_y = vy - v_cm_y;
-    double v_rel_z = vz - v_cm_z;
-
-    double v_rel = std::sqrt(v_rel_x*v_rel_x + v_rel_y*v_rel_y + v_rel_z*v_rel_z);
-
-    auto angles = getRandomSphericalCoordinates();
-    double phi = angles.first;
-    double theta = angles.second;
-
-    double ux = std::sin(theta) * std::cos(phi);
-    double uy = std::sin(theta) * std::sin(phi);
-    double uz = std::cos(theta);
-
-    double v_rel_x_new = v_rel * ux;
-    double v_rel_y_new = v_rel * uy;
-    double v_rel_z_new = v_rel * uz;
-
-    double v_final_x = v_rel_x_new + v_cm_x;
-    double v_final_y = v_rel_y_new + v_cm_y;
-    double v_final_z = v_rel_z_new + v_cm_z;
-
-    velocity = {v_final_x, v_final_y, v_final_z};
+    auto direction = sampleIsotropicDirection(rng);
+    ElasticScatter::apply(mass, A, velocity, direction);
 }
 
 
-void ChargedParticle::propagate(const BaseMaterial& material) {  
-    std::array<double, 3> thermalStep = getThermalStep(material);
+void ChargedParticle::propagate(const BaseMaterial& material, RandomGenerator& rng) {  
+    std::array<double, 3> thermalStep = getThermalStep(material, rng);
 
     double stepLength = sqrt( thermalStep[0] * thermalStep [0] +      
         thermalStep[1] * thermalStep [1] + 
         thermalStep[2] * thermalStep [2] ); // Not possible to use getTermalStepLenght, it would give a different value.
 
     if (const DoubleSlab* slab = dynamic_cast<const DoubleSlab*>(&material)) {
-        propagate(*slab);
+        propagate(*slab, rng);
         return;
     }
 
@@ -137,7 +91,7 @@ void ChargedParticle::propagate(const BaseMaterial& material) {
     }
 
     if (material.hasElasticScattering(*this)) {
-        elasticScatter(material);
+        elasticScatter(material, rng);
     } else {
         applyDragForce(material);
     }
@@ -147,28 +101,24 @@ void ChargedParticle::propagate(const BaseMaterial& material) {
     
 }
 
-void ChargedParticle::propagate(const DoubleSlab&  doubleSlab) {
+void ChargedParticle::propagate(const DoubleSlab&  doubleSlab, RandomGenerator& rng) {
     double lambda1 = doubleSlab.getMaterial1().getLambda(*this);
     double lambda2 = doubleSlab.getMaterial2().getLambda(*this);
     double lambda_min = std::min(lambda1, lambda2);
 
-    double step_length = getRandomStepLength(doubleSlab)/doubleSlab.getLambda(*this) * lambda_min; 
+    double step_length = getRandomStepLength(doubleSlab, rng)/doubleSlab.getLambda(*this) * lambda_min; 
 
     bool in_mat1 = doubleSlab.getMaterial1().isWithinBounds(*this);
     bool in_mat2 = doubleSlab.getMaterial2().isWithinBounds(*this);
 
     if (!in_mat1 && !in_mat2) return;
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<> distrib(0, 1);
-
     double P_collision = 0.0;
     const RegularSlab* collision_material = nullptr;
 
     if (in_mat1 && in_mat2) {
         P_collision = (lambda_min/lambda1 + lambda_min/lambda2) / 2.0;
-        collision_material = (distrib(gen) < lambda2/(lambda1 + lambda2)) ? 
+        collision_material = (rng.uniform() < lambda2/(lambda1 + lambda2)) ? 
                            &doubleSlab.getMaterial1() : &doubleSlab.getMaterial2();
     } 
     else if (in_mat1) {
@@ -180,8 +130,8 @@ void ChargedParticle::propagate(const DoubleSlab&  doubleSlab) {
         collision_material = &doubleSlab.getMaterial2();
     }
 
-    if (distrib(gen) < P_collision && collision_material) {
-        propagate(*collision_material); // This is what changes the velocity direction and modulus. If it does not enter here, the velocity does not change
+    if (rng.uniform() < P_collision && collision_material) {
+        propagate(*collision_material, rng); // This is what changes the velocity direction and modulus. If it does not enter here, the velocity does not change
     } else {
         for (int i = 0; i < 3; ++i) {
             position[i] += step_length; // Just apply the non thermal velocity to the accepted steps. Otherwise, it is applied more often than it should
@@ -2,7 +2,6 @@
 #include "particle.hpp"
 
 bool DoubleSlab::isWithinBounds(const  Particle& particle) const {
-    double x = particle.getPosition()[0];
-    return x >= xinit && x <= xinit + totalLength;
+    const std::array<double, 3> position = particle.getPosition();
+    return contains(position[0], position[1], position[2]);
 }
-
@@ -0,0 +1,118 @@
+#include "elasticscatter.hpp"
+#include "simd.hpp"
+#include <cmath>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SCATTER_HAVE_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Reference arithmetic, operation for operation that of the former Neutron and
+// ChargedParticle::elasticScatter (1 * v is exact, so a neutron is mass 1). Out of line
+// so the SIMD kernels that finish on it never compile it for a target with FMA.
+__attribute__((noinline))
+void scatterScalar(double mass, const double* atomicMass, double* vx, double* vy, double* vz,
+                   const double* ux, const double* uy, const double* uz, int n) {
+    for (int i = 0; i < n; ++i) {
+        const double cmX = (mass * vx[i]) / (mass + atomicMass[i]);
+        const double cmY = (mass * vy[i]) / (mass + atomicMass[i]);
+        const double cmZ = (mass * vz[i]) / (mass + atomicMass[i]);
+        const double relX = vx[i] - cmX;
+        const double relY = vy[i] - cmY;
+        const double relZ = vz[i] - cmZ;
+        const double rel = std::sqrt(relX * relX + relY * relY + relZ * relZ);
+        vx[i] = rel * ux[i] + cmX;
+        vy[i] = rel * uy[i] + cmY;
+        vz[i] = rel * uz[i] + cmZ;
+    }
+}
+
+#ifdef SCATTER_HAVE_SIMD
+
+__attribute__((target("avx2")))
+void scatterAvx2(double mass, const double* atomicMass, double* vx, double* vy, double* vz,
+                 const double* ux, const double* uy, const double* uz, int n) {
+    const __m256d m = _mm256_set1_pd(mass);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d total = _mm256_add_pd(m, _mm256_loadu_pd(atomicMass + i));
+        const __m256d x = _mm256_loadu_pd(vx + i);
+        const __m256d y = _mm256_loadu_pd(vy + i);
+        const __m256d z = _mm256_loadu_pd(vz + i);
+        const __m256d cmX = _mm256_div_pd(_mm256_mul_pd(m, x), total);
+        const __m256d cmY = _mm256_div_pd(_mm256_mul_pd(m, y), total);
+        const __m256d cmZ = _mm256_div_pd(_mm256_mul_pd(m, z), total);
+        const __m256d relX = _mm256_sub_pd(x, cmX);
+        const __m256d relY = _mm256_sub_pd(y, cmY);
+        const __m256d relZ = _mm256_sub_pd(z, cmZ);
+        const __m256d rel = _mm256_sqrt_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(relX, relX),
+                                                                       _mm256_mul_pd(relY, relY)),
+                                                         _mm256_mul_pd(relZ, relZ)));
+        _mm256_storeu_pd(vx + i, _mm256_add_pd(_mm256_mul_pd(rel, _mm256_loadu_pd(ux + i)), cmX));
+        _mm256_storeu_pd(vy + i, _mm256_add_pd(_mm256_mul_pd(rel, _mm256_loadu_pd(uy + i)), cmY));
+        _mm256_storeu_pd(vz + i, _mm256_add_pd(_mm256_mul_pd(rel, _mm256_loadu_pd(uz + i)), cmZ));
+    }
+    scatterScalar(mass, atomicMass + i, vx + i, vy + i, vz + i, ux + i, uy + i, uz + i, n - i);
+}
+
+// Explicit rounding forms: GCC would fuse plain AVX-512 multiplies and adds into FMAs
+// (zero-masked, as the unmasked ones start from an undefined register)
+const int kRound = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
+
+__attribute__((target("avx512f")))
+inline __m512d mul(__m512d a, __m512d b) { return _mm512_maskz_mul_round_pd(0xFF, a, b, kRound); }
+
+__attribute__((target("avx512f")))
+inline __m512d add(__m512d a, __m512d b) { return _mm512_maskz_add_round_pd(0xFF, a, b, kRound); }
+
+__attribute__((target("avx512f")))
+inline __m512d sub(__m512d a, __m512d b) { return _mm512_maskz_sub_round_pd(0xFF, a, b, kRound); }
+
+__attribute__((target("avx512f")))
+inline __m512d div(__m512d a, __m512d b) { return _mm512_maskz_div_round_pd(0xFF, a, b, kRound); }
+
+__attribute__((target("avx512f")))
+void scatterAvx512(double mass, const double* atomicMass, double* vx, double* vy, double* vz,
+                   const double* ux, const double* uy, const double* uz, int n) {
+    const __m512d m = _mm512_set1_pd(mass);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m512d total = add(m, _mm512_loadu_pd(atomicMass + i));
+        const __m512d x = _mm512_loadu_pd(vx + i);
+        const __m512d y = _mm512_loadu_pd(vy + i);
+        const __m512d z = _mm512_loadu_pd(vz + i);
+        const __m512d cmX = div(mul(m, x), total);
+        const __m512d cmY = div(mul(m, y), total);
+        const __m512d cmZ = div(mul(m, z), total);
+        const __m512d relX = sub(x, cmX);
+        const __m512d relY = sub(y, cmY);
+        const __m512d relZ = sub(z, cmZ);
+        const __m512d rel2 = add(add(mul(relX, relX), mul(relY, relY)), mul(relZ, relZ));
+        const __m512d rel = _mm512_maskz_sqrt_round_pd(0xFF, rel2, kRound);
+        _mm512_storeu_pd(vx + i, add(mul(rel, _mm512_loadu_pd(ux + i)), cmX));
+        _mm512_storeu_pd(vy + i, add(mul(rel, _mm512_loadu_pd(uy + i)), cmY));
+        _mm512_storeu_pd(vz + i, add(mul(rel, _mm512_loadu_pd(uz + i)), cmZ));
+    }
+    scatterScalar(mass, atomicMass + i, vx + i, vy + i, vz + i, ux + i, uy + i, uz + i, n - i);
+}
+
+#endif
+
+}
+
+void ElasticScatter::apply(double mass, double atomicMass, std::array<double, 3>& velocity,
+                           const std::array<double, 3>& direction) {
+    scatterScalar(mass, &atomicMass, &velocity[0], &velocity[1], &velocity[2],
+                  &direction[0], &direction[1], &direction[2], 1);
+}
+
+void ElasticScatter::apply(double mass, const double* atomicMass, double* vx, double* vy, double* vz,
+                           const double* ux, const double* uy, const double* uz, int n) {
+#ifdef SCATTER_HAVE_SIMD
+    if (simdLevel() == SimdLevel::Avx512) return scatterAvx512(mass, atomicMass, vx, vy, vz, ux, uy, uz, n);
+    if (simdLevel() == SimdLevel::Avx2) return scatterAvx2(mass, atomicMass, vx, vy, vz, ux, uy, uz, n);
+#endif
+    scatterScalar(mass, atomicMass, vx, vy, vz, ux, uy, uz, n);
+}
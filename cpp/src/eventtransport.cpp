@@ -0,0 +1,390 @@
+#include "eventtransport.hpp"
+#include "elasticscatter.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// Particle type and active physics of a kernel
+template <bool Charged, bool Scatter, bool Drag>
+struct Physics {
+    static const bool charged = Charged;  ///< Charged particle (otherwise neutron)
+    static const bool scatter = Scatter;  ///< Some region has an atomic mass
+    static const bool drag = Drag;        ///< Some region has k != 0
+};
+
+}
+
+// Turns the run-time flags into template arguments, one at a time
+template <typename Geometry, bool... Flags>
+struct EventTransport::KernelTable {
+    template <typename... Rest>
+    static Kernel pick(bool flag, Rest... rest) {
+        return flag ? KernelTable<Geometry, Flags..., true>::pick(rest...)
+                    : KernelTable<Geometry, Flags..., false>::pick(rest...);
+    }
+
+    static Kernel pick() {
+        return &EventTransport::runKernel<Physics<Flags...>, Geometry>;
+    }
+};
+
+void ParticleBank::resize(int lanes) {
+    for (std::vector<double>* array : {&x, &y, &z, &vx, &vy, &vz, &energy, &tx, &ty, &tz, &path}) {
+        array->assign(lanes, 0.0);
+    }
+    alive.assign(lanes, 0);
+    inside.assign(lanes, 0);
+    in1.assign(lanes, 0);
+    in2.assign(lanes, 0);
+    region.assign(lanes, 0);
+    stopped.assign(lanes, 0);
+    moves.assign(lanes, 0);
+    history.assign(lanes, 0);
+}
+
+void ScatterBatch::resize(int lanes) {
+    lane.assign(lanes, 0);
+    for (std::vector<double>* array : {&vx, &vy, &vz, &ux, &uy, &uz, &atomicMass}) {
+        array->assign(lanes, 0.0);
+    }
+    size = 0;
+}
+
+EventTransport::EventTransport(const TransportSettings& settings, std::vector<std::unique_ptr<RandomGenerator>> generators)
+    : settings(settings), charged(settings.particleType == "charged"), generators(std::move(generators))
+{
+    bank.resize(static_cast<int>(this->generators.size()));
+    scatters.resize(static_cast<int>(this->generators.size()));
+    active.reserve(this->generators.size());
+}
+
+// Picks the kernel of the material (the only dynamic_cast of the loop) and of its
+// physics, and reads its collision parameters
+void EventTransport::prepare(const BaseMaterial& material) {
+    // The accessors of the materials take a particle, which simple materials ignore
+    std::unique_ptr<Particle> probe = createParticle(settings);
+    auto regionOf = [&](const BaseMaterial& m) {
+        Region region = {m.getLambda(*probe), m.getPabs(*probe), m.getK(*probe), m.getAtomicMass(*probe),
+                         m.getStoppingPower(*probe)};
+        return region;
+    };
+
+    const RegularSlab* regularSlab = dynamic_cast<const RegularSlab*>(&material);
+    const FiniteSlab* finiteSlab = dynamic_cast<const FiniteSlab*>(&material);
+    const Sphere* sphere = dynamic_cast<const Sphere*>(&material);
+    const DoubleSlab* doubleSlab = dynamic_cast<const DoubleSlab*>(&material);
+    int numRegions = 1;
+    hasEntryPlane = false;
+    if (regularSlab) {
+        regions[0] = regionOf(*regularSlab);
+        hasEntryPlane = (settings.shape == "regular_slab");
+        entryPlane = regularSlab->getXInit();
+    } else if (finiteSlab) {
+        regions[0] = regionOf(*finiteSlab);
+    } else if (sphere) {
+        regions[0] = regionOf(*sphere);
+    } else if (doubleSlab) {
+        regions[0] = regionOf(doubleSlab->getMaterial1());
+        regions[1] = regionOf(doubleSlab->getMaterial2());
+        numRegions = 2;
+        hasEntryPlane = (settings.shape == "double_slab");
+        entryPlane = doubleSlab->getXInit();
+    } else {
+        throw std::runtime_error("Event-based transport does not support this material");
+    }
+
+    bool scatter = false, drag = false;
+    for (int r = 0; r < numRegions; r++) {
+        scatter = scatter || regions[r].atomicMass > 0.0;
+        drag = drag || regions[r].k != 0.0;
+    }
+
+    if (regularSlab) kernel = KernelTable<RegularSlab>::pick(charged, scatter, drag);
+    else if (finiteSlab) kernel = KernelTable<FiniteSlab>::pick(charged, scatter, drag);
+    else if (sphere) kernel = KernelTable<Sphere>::pick(charged, scatter, drag);
+    else kernel = KernelTable<DoubleSlab>::pick(charged, scatter, drag);
+    prepared = &material;
+}
+
+void EventTransport::load(int lane, int run, std::int64_t history, const ScrambledSobol& sobol) {
+    RandomGenerator& rng = *generators[lane];
+    rng.setStream(static_cast<std::uint32_t>(run), static_cast<std::uint64_t>(history));
+    if (settings.rqmc) {
+        rng.setLeadingSamples(sobol.point(static_cast<std::uint32_t>(history)));
+    }
+
+    const double mass = charged ? settings.mass : 1.0;
+    bank.x[lane] = settings.position[0];
+    bank.y[lane] = settings.position[1];
+    bank.z[lane] = settings.position[2];
+    bank.vx[lane] = settings.velocity[0];
+    bank.vy[lane] = settings.velocity[1];
+    bank.vz[lane] = settings.velocity[2];
+    bank.energy[lane] = 0.5 * mass * (bank.vx[lane] * bank.vx[lane] + bank.vy[lane] * bank.vy[lane] +
+                                      bank.vz[lane] * bank.vz[lane]);
+    bank.alive[lane] = 1;
+    bank.region[lane] = 0;
+    bank.stopped[lane] = 0;
+    bank.history[lane] = history;
+}
+
+// Free flight in a single-material geometry: always ends in a collision
+template <typename Geometry>
+void EventTransport::sampleFlight(const Geometry&, int lane) {
+    RandomGenerator& rng = *generators[lane];
+    const double r = regions[0].lambda * rng.exponential();
+    const std::array<double, 3> direction = rng.isotropicDirection();
+    bank.region[lane] = 0;
+    bank.moves[lane] = 1;
+    bank.tx[lane] = r * direction[0];
+    bank.ty[lane] = r * direction[1];
+    bank.tz[lane] = r * direction[2];
+    bank.path[lane] = std::sqrt(bank.tx[lane] * bank.tx[lane] + bank.ty[lane] * bank.ty[lane] +
+                                bank.tz[lane] * bank.tz[lane]);
+}
+
+// Region masks of the first lanes of the bank, read by the flight and the absorption of
+// a double slab (single-material geometries need none)
+void EventTransport::locate(const DoubleSlab& slab, int lanes) {
+    slab.getMaterial1().containsBatch(bank.x.data(), bank.y.data(), bank.z.data(), bank.in1.data(), lanes);
+    slab.getMaterial2().containsBatch(bank.x.data(), bank.y.data(), bank.z.data(), bank.in2.data(), lanes);
+}
+
+// Free flight in a double slab: picks the region of the collision, or a straight step
+// instead (see Neutron::propagate)
+void EventTransport::sampleFlight(const DoubleSlab&, int lane) {
+    RandomGenerator& rng = *generators[lane];
+    const Region& r1 = regions[0];
+    const Region& r2 = regions[1];
+    const double lambdaMin = std::min(r1.lambda, r2.lambda);
+    const bool in1 = bank.in1[lane];
+    const bool in2 = bank.in2[lane];
+    const double lambda = in1 ? r1.lambda : r2.lambda;
+
+    // Thermal step of the composite material, drawn and discarded by the analog loop
+    rng.exponential();
+    rng.isotropicDirection();
+    double straight = lambda * rng.exponential() / lambda * lambdaMin;
+
+    int region = 0;
+    double pCollision = 0.0;
+    if (in1 && in2) {
+        pCollision = (lambdaMin / r1.lambda + lambdaMin / r2.lambda) / 2.0;
+        region = (rng.uniform() < r2.lambda / (r1.lambda + r2.lambda)) ? 0 : 1;
+    } else if (in1) {
+        pCollision = lambdaMin / r1.lambda;
+    } else if (in2) {
+        pCollision = lambdaMin / r2.lambda;
+        region = 1;
+    } else {
+        // Outside both regions the particle does not move
+        straight = 0.0;
+    }
+
+    if ((in1 || in2) && rng.uniform() < pCollision) {
+        const double r = regions[region].lambda * rng.exponential();
+        const std::array<double, 3> direction = rng.isotropicDirection();
+        bank.region[lane] = static_cast<std::int8_t>(region);
+        bank.moves[lane] = 1;
+        bank.tx[lane] = r * direction[0];
+        bank.ty[lane] = r * direction[1];
+        bank.tz[lane] = r * direction[2];
+        bank.path[lane] = std::sqrt(bank.tx[lane] * bank.tx[lane] + bank.ty[lane] * bank.ty[lane] +
+                                    bank.tz[lane] * bank.tz[lane]);
+    } else {
+        bank.moves[lane] = 0;
+        bank.tx[lane] = bank.ty[lane] = bank.tz[lane] = straight;
+    }
+}
+
+// Elastic scattering of the lanes whose flight ended in a region with an atomic mass:
+// draws their directions (a particle at rest does not scatter and draws nothing, as in
+// the analog loop), then scatters them all at once
+template <typename Kind>
+void EventTransport::scatter() {
+    scatters.size = 0;
+    for (int lane : active) {
+        const Region& m = regions[bank.region[lane]];
+        if (!bank.moves[lane] || m.atomicMass <= 0.0) continue;
+        const double vx = bank.vx[lane], vy = bank.vy[lane], vz = bank.vz[lane];
+        if (std::sqrt(vx * vx + vy * vy + vz * vz) == 0.0) continue;
+
+        const std::array<double, 3> direction = generators[lane]->isotropicDirection();
+        const int i = scatters.size++;
+        scatters.lane[i] = lane;
+        scatters.vx[i] = vx;
+        scatters.vy[i] = vy;
+        scatters.vz[i] = vz;
+        scatters.ux[i] = direction[0];
+        scatters.uy[i] = direction[1];
+        scatters.uz[i] = direction[2];
+        scatters.atomicMass[i] = m.atomicMass;
+    }
+
+    const double mass = Kind::charged ? settings.mass : 1.0;
+    ElasticScatter::apply(mass, scatters.atomicMass.data(), scatters.vx.data(), scatters.vy.data(),
+                          scatters.vz.data(), scatters.ux.data(), scatters.uy.data(), scatters.uz.data(),
+                          scatters.size);
+    for (int i = 0; i < scatters.size; i++) {
+        const int lane = scatters.lane[i];
+        bank.vx[lane] = scatters.vx[i];
+        bank.vy[lane] = scatters.vy[i];
+        bank.vz[lane] = scatters.vz[i];
+    }
+}
+
+// Drag at the end of a flight outside elastic scattering, then energy loss of charged
+// particles. Same arithmetic as Neutron/ChargedParticle, operation for operation; a
+// drag with k = 0 leaves the velocity unchanged, so kernels without drag skip it.
+// Energy loss always runs for charged particles, even without any stopping power: its
+// rescaling of the velocity by sqrt(2 E / m) / |v| can still change the last bit.
+template <typename Kind>
+void EventTransport::collide(int lane) {
+    const double mass = Kind::charged ? settings.mass : 1.0;
+    const Region& m = regions[bank.region[lane]];
+    double& vx = bank.vx[lane];
+    double& vy = bank.vy[lane];
+    double& vz = bank.vz[lane];
+
+    // Regions with an atomic mass scatter instead (see scatter())
+    if (Kind::drag && !(Kind::scatter && m.atomicMass > 0.0)) {
+        vx *= (1.0 - m.k);
+        vy *= (1.0 - m.k);
+        vz *= (1.0 - m.k);
+    }
+
+    if (Kind::charged && !bank.stopped[lane]) {
+        const double energyLoss = m.stoppingPower * bank.path[lane];
+        const double vMag = std::sqrt(vx * vx + vy * vy + vz * vz);
+        double kineticEnergy = 0.5 * mass * vMag * vMag;
+        kineticEnergy = kineticEnergy - energyLoss;
+
+        if (kineticEnergy <= 0) {
+            bank.stopped[lane] = 1;
+            vx = vy = vz = 0.0;
+            bank.energy[lane] = 0.0;
+        } else {
+            const double vNew = std::sqrt(2 * kineticEnergy / mass);
+            vx *= (vNew / vMag);
+            vy *= (vNew / vMag);
+            vz *= (vNew / vMag);
+            bank.energy[lane] = kineticEnergy;
+        }
+    }
+}
+
+template <typename Kind, typename Geometry>
+bool EventTransport::absorbs(const Geometry&, int lane) {
+    if (Kind::charged && bank.stopped[lane]) return true;
+    return generators[lane]->uniform() < regions[0].pabs;
+}
+
+// Absorption probability of the region the particle is in. A neutron on neither side
+// (only possible through rounding at the interface) is never absorbed.
+template <typename Kind>
+bool EventTransport::absorbs(const DoubleSlab&, int lane) {
+    if (Kind::charged && bank.stopped[lane]) return true;
+    if (bank.in1[lane]) {
+        return generators[lane]->uniform() < regions[0].pabs;
+    }
+    if (Kind::charged || bank.in2[lane]) {
+        return generators[lane]->uniform() < regions[1].pabs;
+    }
+    return false;
+}
+
+template <typename Kind, typename Geometry>
+void EventTransport::runKernel(const BaseMaterial& material, int run, std::int64_t begin, std::int64_t end) {
+    const Geometry& geometry = static_cast<const Geometry&>(material);
+    ScrambledSobol sobol(settings.seed, run);
+
+    std::int64_t next = begin;
+    active.clear();
+    for (int lane = 0; lane < bank.size() && next < end; lane++) {
+        load(lane, run, next++, sobol);
+        active.push_back(lane);
+    }
+
+    while (!active.empty()) {
+        // Active lanes stay in increasing order, so the checks sweep the lanes up to the
+        // last active one (finished lanes in between are checked and ignored)
+        const int lanes = active.back() + 1;
+
+        // Flight
+        locate(geometry, lanes);
+        for (int lane : active) sampleFlight(geometry, lane);
+
+        // Move: thermal step plus drift; straight double-slab steps carry no drift
+        for (int lane : active) {
+            if (bank.moves[lane]) {
+                bank.x[lane] += bank.tx[lane] + bank.vx[lane];
+                bank.y[lane] += bank.ty[lane] + bank.vy[lane];
+                bank.z[lane] += bank.tz[lane] + bank.vz[lane];
+            } else {
+                bank.x[lane] += bank.tx[lane];
+                bank.y[lane] += bank.ty[lane];
+                bank.z[lane] += bank.tz[lane];
+            }
+        }
+
+        // Collision
+        if (Kind::scatter) scatter<Kind>();
+        for (int lane : active) {
+            if (bank.moves[lane]) collide<Kind>(lane);
+        }
+
+        // Boundary: particles that left are reflected if they crossed the entry plane
+        geometry.containsBatch(bank.x.data(), bank.y.data(), bank.z.data(), bank.inside.data(), lanes);
+        for (int lane : active) {
+            if (bank.inside[lane]) continue;
+            const HistoryOutcome outcome = (hasEntryPlane && bank.x[lane] < entryPlane) ? HistoryOutcome::Reflected
+                                                                                          : HistoryOutcome::Scaped;
+            outcomes[bank.history[lane] - begin] = static_cast<std::uint8_t>(outcome);
+            bank.alive[lane] = 0;
+        }
+
+        // Absorption
+        locate(geometry, lanes);
+        for (int lane : active) {
+            if (bank.alive[lane] && absorbs<Kind>(geometry, lane)) {
+                outcomes[bank.history[lane] - begin] = static_cast<std::uint8_t>(HistoryOutcome::Absorbed);
+                bank.alive[lane] = 0;
+            }
+        }
+
+        // Finished lanes take the next history of the range, or leave the bank
+        size_t kept = 0;
+        for (int lane : active) {
+            if (!bank.alive[lane]) {
+                if (next == end) continue;
+                load(lane, run, next++, sobol);
+            }
+            active[kept++] = lane;
+        }
+        active.resize(kept);
+    }
+}
+
+void EventTransport::transport(const BaseMaterial& material, int run, std::int64_t begin, std::int64_t end,
+                               ReplicaTally& tally) {
+    if (&material != prepared) prepare(material);
+    outcomes.assign(end - begin, 0);
+    (this->*kernel)(material, run, begin, end);
+
+    // Tally in history order, so the replay candidates are those of the analog loop
+    int kept[3] = {0, 0, 0};
+    for (std::int64_t i = begin; i < end; i++) {
+        const HistoryOutcome outcome = static_cast<HistoryOutcome>(outcomes[i - begin]);
+        if (outcome == HistoryOutcome::Absorbed) tally.NumAbsorbed++;
+        else if (outcome == HistoryOutcome::Reflected) tally.NumReflected++;
+        else tally.NumScaped++;
+
+        int& count = kept[static_cast<int>(outcome)];
+        if (count < kRepresentativesPerOutcome) {
+            tally.representatives.push_back({outcome, static_cast<std::uint32_t>(run), static_cast<std::uint64_t>(i)});
+            count++;
+        }
+    }
+}
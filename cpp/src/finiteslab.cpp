@@ -2,8 +2,6 @@
 #include "particle.hpp"
 
 bool FiniteSlab::isWithinBounds(const  Particle& particle) const {
-    double x = particle.getPosition()[0];
-    double y = particle.getPosition()[1];
-    double z = particle.getPosition()[2];
-    return x >= - xlength/2 && x <= xlength/2 && y >= - ylength/2 && y <= ylength/2 && z >= 0 && z <= zlength;
+    const std::array<double, 3> position = particle.getPosition();
+    return contains(position[0], position[1], position[2]);
 }
@@ -0,0 +1,158 @@
+#include "grid.hpp"
+#include "materialfactory.hpp"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace {
+
+// First present key of a section, for fields named differently in the double slab
+double firstOf(const json& section, const char* name, const char* alternative, double fallback) {
+    if (section.contains(name) && section[name].is_number()) return section[name];
+    if (section.contains(alternative) && section[alternative].is_number()) return section[alternative];
+    return fallback;
+}
+
+}
+
+void validateGrid(const json& config, ConfigError& error) {
+    const json& grid = config["grid"];
+    if (!grid.is_object() || grid.empty()) {
+        error.add_error("Error: Configuration value 'grid' must be a non-empty object");
+        return;
+    }
+
+    const size_t previousErrors = error.errors.size();
+    bool hasScale = config["geometry"].contains("scale") && config["geometry"]["scale"].is_number();
+    for (auto it = grid.begin(); it != grid.end(); ++it) {
+        const std::string& key = it.key();
+        size_t dot = key.find('.');
+        std::string section = key.substr(0, dot);
+        if (dot == std::string::npos || dot + 1 == key.size() || (section != "material" && section != "geometry")) {
+            error.add_error("Error: Grid key '" + key + "' must be 'material.<field>' or 'geometry.<field>'");
+            continue;
+        }
+        // A misspelled field would otherwise be written into every job and ignored
+        if (key != "geometry.scale" && !config[section].contains(key.substr(dot + 1))) {
+            error.add_error("Error: Grid key '" + key + "' is not a field of the '" + section + "' section");
+            continue;
+        }
+
+        const json& values = it.value();
+        bool numeric = values.is_array() && !values.empty();
+        for (const json& value : values) {
+            if (!value.is_number()) numeric = false;
+        }
+        if (!numeric) {
+            error.add_error("Error: Grid value 'grid." + key + "' must be a non-empty array of numbers");
+        }
+        if (key == "geometry.scale") hasScale = true;
+    }
+
+    if (!hasScale) {
+        error.add_error("Error: A grid run needs 'geometry.scale', in the geometry or in the grid");
+    }
+    if (error.errors.size() != previousErrors) return;
+
+    // Every combination must pass the checks of a plain configuration
+    for (const GridJob& job : expandGrid(config)) {
+        ConfigError jobError;
+        MaterialFactory factory;
+        factory.validate_config(job.config, jobError);
+        if (!jobError.has_errors()) continue;
+
+        std::string point;
+        const std::vector<GridAxis> axes = gridAxes(config);
+        for (size_t a = 0; a < axes.size(); a++) {
+            point += (a ? ", " : "") + axes[a].name() + " = " + std::to_string(job.values[a]);
+        }
+        for (std::string message : jobError.errors) {
+            if (message.compare(0, 7, "Error: ") == 0) message.erase(0, 7);
+            error.add_error("Error: Grid point (" + point + "): " + message);
+        }
+    }
+}
+
+std::vector<GridAxis> gridAxes(const json& config) {
+    std::vector<GridAxis> axes;
+    for (auto it = config["grid"].begin(); it != config["grid"].end(); ++it) {
+        GridAxis axis;
+        size_t dot = it.key().find('.');
+        axis.section = it.key().substr(0, dot);
+        axis.field = it.key().substr(dot + 1);
+        axis.values = it.value().get<std::vector<double>>();
+        axes.push_back(axis);
+    }
+    return axes;
+}
+
+std::vector<GridJob> expandGrid(const json& config) {
+    std::vector<GridAxis> axes = gridAxes(config);
+    const std::string shape = config["geometry"]["shape"];
+
+    size_t combinations = 1;
+    for (const GridAxis& axis : axes) combinations *= axis.values.size();
+
+    std::vector<GridJob> jobs;
+    for (size_t c = 0; c < combinations; c++) {
+        GridJob job;
+        job.config = config;
+        job.config.erase("grid");
+
+        // Mixed-radix decomposition of c, last axis fastest
+        size_t rest = c;
+        job.values.resize(axes.size());
+        for (size_t a = axes.size(); a-- > 0;) {
+            const GridAxis& axis = axes[a];
+            job.values[a] = axis.values[rest % axis.values.size()];
+            rest /= axis.values.size();
+            job.config[axis.section][axis.field] = job.values[a];
+        }
+
+        job.scale = job.config["geometry"]["scale"];
+        job.estimatedCost = estimateHistoryCost(job.config, shape, job.scale);
+        jobs.push_back(job);
+    }
+    return jobs;
+}
+
+double estimateHistoryCost(const json& config, const std::string& shape, double scale) {
+    const json& material = config["material"];
+    const double lambda = firstOf(material, "mean_free_path", "mean_free_path1", 1.0);
+    const double pabs = firstOf(material, "pabs", "pabs1", 0.0);
+
+    // The double slab is as thick as its total length, whatever the scale
+    const double size = (shape == "double_slab") ? firstOf(config["geometry"], "total_length", "total_length", scale) : scale;
+    const double escape = (size / lambda) * (size / lambda);
+    return 1.0 + (pabs > 0.0 ? std::min(escape, 1.0 / pabs) : escape);
+}
+
+std::vector<GridPoint> runGrid(const json& config, const TransportSettings& settings) {
+    std::vector<GridJob> jobs = expandGrid(config);
+    const bool isCharged = (settings.particleType == "charged");
+
+    std::vector<std::unique_ptr<BaseMaterial>> owned;
+    for (const GridJob& job : jobs) {
+        owned.push_back(MaterialFactory::createMaterial(job.config, settings.shape, job.scale, isCharged));
+        if (!owned.back()->isWithinBounds(*createParticle(settings))) {
+            throw std::runtime_error("The particle starts outside the material of a grid point");
+        }
+    }
+
+    // Most expensive jobs first; ties keep the expansion order
+    std::vector<size_t> order(jobs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return jobs[a].estimatedCost > jobs[b].estimatedCost;
+    });
+
+    std::vector<const BaseMaterial*> materials;
+    for (size_t j : order) materials.push_back(owned[j].get());
+    std::vector<TransportResult> results = runTransport(settings, materials);
+
+    std::vector<GridPoint> points(jobs.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        points[order[i]] = {jobs[order[i]], results[i]};
+    }
+    return points;
+}
@@ -1,9 +1,56 @@
 #include "materialfactory.hpp"
+#include <limits>
+#include <string>
+
+namespace {
+
+// Replicas are counted in int (and replica streams in 32 bits)
+const long long kMaxReplicas = 1000000;
+
+// Histories recorded per replica, counted in int
+const long long kMaxRecordHistories = std::numeric_limits<int>::max();
+
+// Particles in flight per worker, each with its own random generator: a few thousand
+// already fill the caches, and larger banks only cost memory
+const long long kMaxBankSize = 65536;
+
+}
 
 void MaterialFactory::validate_config(const json& config, ConfigError& error) {
     check_json_field(config["run"], "run", error);
     check_json_field(config["run"]["simulations"], "run.simulations", error);
+    if (!config["run"]["simulations"].is_null() &&
+        (!config["run"]["simulations"].is_number_integer() || config["run"]["simulations"].get<long long>() < 1)) {
+        error.add_error("Error: Configuration value 'run.simulations' must be a positive integer");
+    }
     check_json_field(config["run"]["run_name"], "run.run_name", error);
+    if (config["run"].contains("seed") && !config["run"]["seed"].is_null() && !config["run"]["seed"].is_number_unsigned()) {
+        error.add_error("Error: Configuration value 'run.seed' must be a non-negative integer");
+    }
+    if (config["run"].contains("replicas") && !config["run"]["replicas"].is_null() &&
+        (!config["run"]["replicas"].is_number_integer() || config["run"]["replicas"].get<long long>() < 1 ||
+         config["run"]["replicas"].get<long long>() > kMaxReplicas)) {
+        error.add_error("Error: Configuration value 'run.replicas' must be an integer between 1 and " +
+                        std::to_string(kMaxReplicas));
+    }
+    if (config["run"].contains("record_histories") && !config["run"]["record_histories"].is_null() &&
+        (!config["run"]["record_histories"].is_number_integer() || config["run"]["record_histories"].get<long long>() < 0 ||
+         config["run"]["record_histories"].get<long long>() > kMaxRecordHistories)) {
+        error.add_error("Error: Configuration value 'run.record_histories' must be an integer between 0 and " +
+                        std::to_string(kMaxRecordHistories));
+    }
+    if (config["run"].contains("bank_size") && !config["run"]["bank_size"].is_null() &&
+        (!config["run"]["bank_size"].is_number_integer() || config["run"]["bank_size"].get<long long>() < 1 ||
+         config["run"]["bank_size"].get<long long>() > kMaxBankSize)) {
+        error.add_error("Error: Configuration value 'run.bank_size' must be an integer between 1 and " +
+                        std::to_string(kMaxBankSize));
+    }
+    if (config["run"].contains("sampler") && !config["run"]["sampler"].is_null()) {
+        if (!config["run"]["sampler"].is_string() ||
+            (config["run"]["sampler"] != "mc" && config["run"]["sampler"] != "rqmc")) {
+            error.add_error("Error: Configuration value 'run.sampler' must be \"mc\" or \"rqmc\"");
+        }
+    }
     check_json_field(config["geometry"], "geometry", error);
     check_json_field(config["geometry"]["shape"], "geometry.shape", error);
     check_json_field(config["particle"], "particle", error);
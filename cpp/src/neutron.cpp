@@ -1,7 +1,7 @@
 #include "neutron.hpp"
 #include "doubleslab.hpp"
+#include "elasticscatter.hpp"
 #include <fstream>
-#include <random>
 #include <cmath>
 #include <utility>
 
@@ -12,74 +12,30 @@ Neutron::Neutron(double x, double y, double z, double vx, double vy, double vz)
     appendHistory();
 }
 
-double Neutron::getRandomStepLength(const BaseMaterial&  material) {
-    std::random_device rd;  
-    std::mt19937 gen(rd()); 
-
-    int min = 0, max = 1;
-    std::uniform_real_distribution<> distrib(min, max);
-
-    return - material.getLambda(*this) * log(distrib(gen));
+double Neutron::getRandomStepLength(const BaseMaterial&  material, RandomGenerator& rng) {
+    return material.getLambda(*this) * rng.exponential();
 }
 
-std::array<double, 3> Neutron::getThermalStep(const BaseMaterial&  material) {
-    auto InitialCoords = Neutron::getPosition();
-
-    auto r = getRandomStepLength(material);
-    auto angles = getRandomSphericalCoordinates();
-
-    float phi = angles.first;
-    float theta  = angles.second;
-
-    float dx = r * cos(phi) * sin(theta);
-    float dy = r * sin(phi) * sin(theta);
-    float dz = r * cos(theta);
+std::array<double, 3> Neutron::getThermalStep(const BaseMaterial&  material, RandomGenerator& rng) {
+    auto r = getRandomStepLength(material, rng);
+    auto direction = sampleIsotropicDirection(rng);
 
-    std::array<double, 3> DeltaPos = {dx, dy, dz};
+    std::array<double, 3> DeltaPos = {r * direction[0], r * direction[1], r * direction[2]};
 
     return DeltaPos;
 
 }
 
-void Neutron::elasticScatter(const BaseMaterial& material) {
+void Neutron::elasticScatter(const BaseMaterial& material, RandomGenerator& rng) {
     double A = material.getAtomicMass(*this);
     if (A <= 0) return;
 
     double vx = velocity[0], vy = velocity[1], vz = velocity[2];
     double v_initial = std::sqrt(vx*vx + vy*vy + vz*vz);
-    if (v_initial == 0.0) return;  
-
-    double ux0 = vx / v_initial;
-    double uy0 = vy / v_initial;
-    double uz0 = vz / v_initial;
-
-    double v_cm_x = vx / (1.0 + A);
-    double v_cm_y = vy / (1.0 + A);
-    double v_cm_z = vz / (1.0 + A);
-
-    double v_rel_x = vx - v_cm_x;
-    double v_rel_y = vy - v_cm_y;
-    double v_rel_z = vz - v_cm_z;
-
-    double v_rel = std::sqrt(v_rel_x*v_rel_x + v_rel_y*v_rel_y + v_rel_z*v_rel_z);
+    if (v_initial == 0.0) return;
 
-    auto angles = getRandomSphericalCoordinates(); 
-    double phi = angles.first;
-    double theta = angles.second;
-
-    double ux = std::sin(theta) * std::cos(phi);
-    double uy = std::sin(theta) * std::sin(phi);
-    double uz = std::cos(theta);
-
-    double v_rel_x_new = v_rel * ux;
-    double v_rel_y_new = v_rel * uy;
-    double v_rel_z_new = v_rel * uz;
-
-    double v_final_x = v_rel_x_new + v_cm_x;
-    double v_final_y = v_rel_y_new + v_cm_y;
-    double v_final_z = v_rel_z_new + v_cm_z;
-
-    velocity = {v_final_x, v_final_y, v_final_z};
+    auto direction = sampleIsotropicDirection(rng);
+    ElasticScatter::apply(1.0, A, velocity, direction);
 }
 
 
@@ -90,42 +46,30 @@ void Neutron::applyDragForce(const BaseMaterial& material) {
     }
 }
 
-bool Neutron::getAbsorption(const BaseMaterial&  material) const{
-    std::random_device rd;  
-    std::mt19937 gen(rd()); 
-
-    int min = 0, max = 1;
-    std::uniform_real_distribution<> distrib(min, max);
-
+bool Neutron::getAbsorption(const BaseMaterial&  material, RandomGenerator& rng) const{
     if (const DoubleSlab* slab = dynamic_cast<const DoubleSlab*>(&material)) {
-       return getAbsorption(*slab);
+       return getAbsorption(*slab, rng);
     }
 
-    return distrib(gen) < material.getPabs(*this);
+    return rng.uniform() < material.getPabs(*this);
 }
 
-bool Neutron::getAbsorption(const DoubleSlab& material) const{
-    std::random_device rd;  
-    std::mt19937 gen(rd()); 
-
-    int min = 0, max = 1;
-    std::uniform_real_distribution<> distrib(min, max);
-
+bool Neutron::getAbsorption(const DoubleSlab& material, RandomGenerator& rng) const{
     if (material.getMaterial1().isWithinBounds(*this)) {
-        return distrib(gen) < material.getMaterial1().getPabs(*this);
+        return rng.uniform() < material.getMaterial1().getPabs(*this);
     } else if (material.getMaterial2().isWithinBounds(*this)) {
-        return distrib(gen) < material.getMaterial2().getPabs(*this);
+        return rng.uniform() < material.getMaterial2().getPabs(*this);
     }
 
     return false;
 }
 
-void Neutron::propagate(const BaseMaterial&  material) {
+void Neutron::propagate(const BaseMaterial&  material, RandomGenerator& rng) {
 
-    std::array<double, 3> thermalStep = getThermalStep(material);
+    std::array<double, 3> thermalStep = getThermalStep(material, rng);
 
     if (const DoubleSlab* slab = dynamic_cast<const DoubleSlab*>(&material)) {
-        propagate(*slab);
+        propagate(*slab, rng);
         return;
     }
         
@@ -134,7 +78,7 @@ void Neutron::propagate(const BaseMaterial&  material) {
     }
 
     if (material.hasElasticScattering(*this)) {
-        elasticScatter(material);
+        elasticScatter(material, rng);
     } else {
         applyDragForce(material);
     }
@@ -142,29 +86,25 @@ void Neutron::propagate(const BaseMaterial&  material) {
     appendHistory();
 }
 
-void Neutron::propagate(const DoubleSlab& doubleSlab) {
+void Neutron::propagate(const DoubleSlab& doubleSlab, RandomGenerator& rng) {
 
     double lambda1 = doubleSlab.getMaterial1().getLambda(*this);
     double lambda2 = doubleSlab.getMaterial2().getLambda(*this);
     double lambda_min = std::min(lambda1, lambda2);
 
-    double step_length = getRandomStepLength(doubleSlab)/doubleSlab.getLambda(*this) * lambda_min; 
+    double step_length = getRandomStepLength(doubleSlab, rng)/doubleSlab.getLambda(*this) * lambda_min; 
 
     bool in_mat1 = doubleSlab.getMaterial1().isWithinBounds(*this);
     bool in_mat2 = doubleSlab.getMaterial2().isWithinBounds(*this);
 
     if (!in_mat1 && !in_mat2) return;
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<> distrib(0, 1);
-
     double P_collision = 0.0;
     const RegularSlab* collision_material = nullptr;
 
     if (in_mat1 && in_mat2) {
         P_collision = (lambda_min/lambda1 + lambda_min/lambda2) / 2.0;
-        collision_material = (distrib(gen) < lambda2/(lambda1 + lambda2)) ? 
+        collision_material = (rng.uniform() < lambda2/(lambda1 + lambda2)) ? 
                            &doubleSlab.getMaterial1() : &doubleSlab.getMaterial2();
     } 
     else if (in_mat1) {
@@ -176,8 +116,8 @@ void Neutron::propagate(const DoubleSlab& doubleSlab) {
         collision_material = &doubleSlab.getMaterial2();
     }
 
-    if (distrib(gen) < P_collision && collision_material) {
-        propagate(*collision_material); // This is what changes the velocity direction and modulus. If it does not enter here, the velocity does not change
+    if (rng.uniform() < P_collision && collision_material) {
+        propagate(*collision_material, rng); // This is what changes the velocity direction and modulus. If it does not enter here, the velocity does not change
     } else {
         for (int i = 0; i < 3; ++i) {
             position[i] += step_length; // Just apply the non thermal velocity to the accepted steps. Otherwise, it is applied more often than it should
@@ -0,0 +1,200 @@
+#include "rng.hpp"
+#include "ziggurat.hpp"
+#include <random>
+#include <cmath>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define RNG_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Packs one Philox block into two 64-bit words
+inline void blockToWords(std::uint32_t w0, std::uint32_t w1, std::uint32_t w2, std::uint32_t w3, std::uint64_t* out) {
+    out[0] = (static_cast<std::uint64_t>(w1) << 32) | w0;
+    out[1] = (static_cast<std::uint64_t>(w3) << 32) | w2;
+}
+
+void bitsScalar(Philox4x32::Counter ctr, Philox4x32::Key key, std::uint64_t* out, int n) {
+    for (int i = 0; i < n; i += 2) {
+        const Philox4x32::Counter block = Philox4x32::generate(ctr, key);
+        blockToWords(block[0], block[1], block[2], block[3], out + i);
+        ++ctr[0];
+    }
+}
+
+#ifdef RNG_HAVE_AVX2
+
+// High and low halves of the 32x32 products of the eight lanes of a with m
+__attribute__((target("avx2")))
+inline void mulhilo(__m256i a, __m256i m, __m256i& hi, __m256i& lo) {
+    const __m256i even = _mm256_mul_epu32(a, m);
+    const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);
+    lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+    hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+}
+
+// Eight Philox blocks per iteration, one counter per 32-bit lane
+__attribute__((target("avx2")))
+void bitsAvx2(Philox4x32::Counter ctr, Philox4x32::Key key, std::uint64_t* out, int n) {
+    const __m256i m0 = _mm256_set1_epi32(static_cast<int>(0xD2511F53u));
+    const __m256i m1 = _mm256_set1_epi32(static_cast<int>(0xCD9E8D57u));
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+    alignas(32) std::uint32_t w[4][8];
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i c0 = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(ctr[0])), lane);
+        __m256i c1 = _mm256_set1_epi32(static_cast<int>(ctr[1]));
+        __m256i c2 = _mm256_set1_epi32(static_cast<int>(ctr[2]));
+        __m256i c3 = _mm256_set1_epi32(static_cast<int>(ctr[3]));
+        Philox4x32::Key k = key;
+
+        for (int r = 0; r < 10; ++r) {
+            if (r > 0) {
+                k[0] += 0x9E3779B9u;
+                k[1] += 0xBB67AE85u;
+            }
+            __m256i hi0, lo0, hi1, lo1;
+            mulhilo(c0, m0, hi0, lo0);
+            mulhilo(c2, m1, hi1, lo1);
+            c0 = _mm256_xor_si256(_mm256_xor_si256(hi1, c1), _mm256_set1_epi32(static_cast<int>(k[0])));
+            c1 = lo1;
+            c2 = _mm256_xor_si256(_mm256_xor_si256(hi0, c3), _mm256_set1_epi32(static_cast<int>(k[1])));
+            c3 = lo0;
+        }
+
+        _mm256_store_si256(reinterpret_cast<__m256i*>(w[0]), c0);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(w[1]), c1);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(w[2]), c2);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(w[3]), c3);
+        for (int j = 0; j < 8; ++j) {
+            blockToWords(w[0][j], w[1][j], w[2][j], w[3][j], out + i + 2 * j);
+        }
+        ctr[0] += 8;
+    }
+    // The target attribute does not make the compiler clear the upper halves on exit,
+    // and leaving them dirty slows down the SSE code of libm that runs right after
+    _mm256_zeroupper();
+
+    bitsScalar(ctr, key, out + i, n - i);
+}
+
+bool cpuHasAvx2() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+const bool kAvx2Available = cpuHasAvx2();
+bool avx2Enabled = kAvx2Available;
+
+#endif
+
+}
+
+void Philox4x32::bits(Counter ctr, Key key, std::uint64_t* out, int n) {
+#ifdef RNG_HAVE_AVX2
+    if (avx2Enabled) {
+        bitsAvx2(ctr, key, out, n);
+        return;
+    }
+#endif
+    bitsScalar(ctr, key, out, n);
+}
+
+bool Philox4x32::simdAvailable() {
+#ifdef RNG_HAVE_AVX2
+    return avx2Enabled;
+#else
+    return false;
+#endif
+}
+
+void Philox4x32::setSimdEnabled(bool enabled) {
+#ifdef RNG_HAVE_AVX2
+    avx2Enabled = enabled && kAvx2Available;
+#endif
+}
+
+RandomGenerator::RandomGenerator(std::uint64_t seed)
+    : seed(seed), currentReplica(0), currentHistory(0)
+{
+    // Build the ziggurat tables up front rather than inside the transport loop
+    ExponentialZiggurat::instance();
+    setStream(0, 0);
+}
+
+std::uint64_t RandomGenerator::randomSeed() {
+    std::random_device rd;
+    return (static_cast<std::uint64_t>(rd()) << 32) ^ rd();
+}
+
+void RandomGenerator::setLeadingSamples(const ScrambledSobol::Point& point) {
+    fillExponentials();
+    exponentials[0] = -std::log(1.0 - point[0]);
+
+    // Direct inversion keeps the low-discrepancy structure that rejection would break
+    fillDirections();
+    const double cosTheta = 2.0 * point[1] - 1.0;
+    const double sinTheta = std::sqrt(1.0 - cosTheta * cosTheta);
+    const double phi = 2.0 * M_PI * point[2];
+    directions[0] = {{sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta}};
+
+    fillUniforms();
+    uniforms[0] = point[3];
+}
+
+void RandomGenerator::fillUniforms() {
+    std::uint64_t w[kBatch];
+    nextWords(kUniformStream, w, kBatch);
+    for (int i = 0; i < kBatch; ++i) {
+        uniforms[i] = toUniform(w[i]);
+    }
+    uniformIndex = 0;
+}
+
+void RandomGenerator::fillExponentials() {
+    // The ziggurat occasionally needs more than one word per sample, so the pool of
+    // random words is topped up on demand
+    const ExponentialZiggurat& ziggurat = ExponentialZiggurat::instance();
+    std::uint64_t w[kBatch];
+    int used = kBatch;
+    auto nextBits = [&]() {
+        if (used == kBatch) {
+            nextWords(kExponentialStream, w, kBatch);
+            used = 0;
+        }
+        return w[used++];
+    };
+
+    for (int i = 0; i < kBatch; ++i) {
+        exponentials[i] = ziggurat.sample(nextBits);
+    }
+    exponentialIndex = 0;
+}
+
+void RandomGenerator::fillDirections() {
+    // Marsaglia (1972): a point drawn uniformly in the unit disc maps to a point on
+    // the unit sphere with one sqrt and no trigonometric calls. A pair is accepted
+    // with probability pi/4, so the pool is topped up when it runs out.
+    std::uint64_t w[2 * kBatch];
+    int used = 2 * kBatch;
+    int filled = 0;
+    while (filled < kBatch) {
+        if (used == 2 * kBatch) {
+            nextWords(kDirectionStream, w, 2 * kBatch);
+            used = 0;
+        }
+        const double a = 2.0 * toUniform(w[used]) - 1.0;
+        const double b = 2.0 * toUniform(w[used + 1]) - 1.0;
+        used += 2;
+
+        const double s = a * a + b * b;
+        if (s >= 1.0) continue;
+
+        const double scale = 2.0 * std::sqrt(1.0 - s);
+        directions[filled++] = {{a * scale, b * scale, 1.0 - 2.0 * s}};
+    }
+    directionIndex = 0;
+}
@@ -0,0 +1,208 @@
+#include "scheduler.hpp"
+#include "topology.hpp"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Range {
+    std::int64_t begin, end, grain;
+};
+
+// Deque of pending ranges of one worker. Ranges are split lazily, so a lock per
+// operation is cheap next to the chunk it hands out.
+struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<Range> ranges;
+
+    // Owner side: takes up to grain indices from the front
+    bool pop(Range& chunk) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (ranges.empty()) return false;
+        Range& front = ranges.front();
+        chunk = {front.begin, std::min(front.end, front.begin + front.grain), front.grain};
+        front.begin = chunk.end;
+        if (front.begin == front.end) ranges.pop_front();
+        return true;
+    }
+
+    // Thief side: takes the back half of the last range (or all of it if it is small)
+    bool steal(Range& stolen) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (ranges.empty()) return false;
+        Range& back = ranges.back();
+        const std::int64_t size = back.end - back.begin;
+        if (size > back.grain) {
+            stolen = {back.end - size / 2, back.end, back.grain};
+            back.end = stolen.begin;
+        } else {
+            stolen = back;
+            ranges.pop_back();
+        }
+        return true;
+    }
+
+    void push(const Range& range) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ranges.push_back(range);
+    }
+};
+
+double seconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+}
+
+WorkStealingScheduler::WorkStealingScheduler(int workers, bool pin, int firstCpu)
+    : numWorkers(std::max(1, workers)), pin(pin), firstCpu(firstCpu), workerStats(numWorkers) {}
+
+std::int64_t WorkStealingScheduler::defaultGrain(std::int64_t n, int workers) {
+    return std::max<std::int64_t>(1, std::min<std::int64_t>(1024, n / (32 * std::max(1, workers))));
+}
+
+void WorkStealingScheduler::parallelFor(std::int64_t n, std::int64_t grain, const Body& body) {
+    parallelFor(n, grain, body, WorkerInit());
+}
+
+void WorkStealingScheduler::parallelFor(std::int64_t n, std::int64_t grain, const Body& body,
+                                        const WorkerInit& init) {
+    std::vector<WorkTask> tasks;
+    if (n > 0) tasks.push_back({0, n, grain, static_cast<double>(n)});
+    parallelFor(tasks, body, init);
+}
+
+std::vector<std::vector<WorkTask>> WorkStealingScheduler::partition(const std::vector<WorkTask>& tasks, int parts) {
+    parts = std::max(1, parts);
+    std::vector<std::vector<WorkTask>> shares(parts);
+
+    // Without costs, split by number of indices
+    double total = 0.0;
+    for (const WorkTask& task : tasks) total += task.cost;
+    const bool byCount = !(total > 0.0);
+    if (byCount) {
+        total = 0.0;
+        for (const WorkTask& task : tasks) total += static_cast<double>(task.end - task.begin);
+    }
+
+    int part = 0;
+    double done = 0.0;
+    for (WorkTask task : tasks) {
+        double cost = byCount ? static_cast<double>(task.end - task.begin) : task.cost;
+        // Cut the task at every part boundary it crosses
+        while (part < parts - 1 && done + cost > total * (part + 1) / parts && task.end - task.begin > 1) {
+            const double fraction = (total * (part + 1) / parts - done) / cost;
+            const std::int64_t cut = task.begin + static_cast<std::int64_t>(fraction * (task.end - task.begin) + 0.5);
+            if (cut > task.begin && cut < task.end) {
+                const double headCost = cost * (cut - task.begin) / (task.end - task.begin);
+                WorkTask head = task;
+                head.end = cut;
+                head.cost = task.cost * (cut - task.begin) / (task.end - task.begin);
+                shares[part].push_back(head);
+                task.cost -= head.cost;
+                task.begin = cut;
+                done += headCost;
+                cost -= headCost;
+            }
+            part++;
+        }
+        shares[part].push_back(task);
+        done += cost;
+    }
+    return shares;
+}
+
+void WorkStealingScheduler::parallelFor(const std::vector<WorkTask>& tasks, const Body& body,
+                                        const WorkerInit& init) {
+    std::vector<WorkerQueue> queues(numWorkers);
+    std::vector<std::vector<WorkTask>> shares = partition(tasks, numWorkers);
+    for (int w = 0; w < numWorkers; w++) {
+        for (const WorkTask& task : shares[w]) {
+            if (task.begin < task.end) {
+                queues[w].ranges.push_back({task.begin, task.end, std::max<std::int64_t>(1, task.grain)});
+            }
+        }
+    }
+    workerStats.assign(numWorkers, WorkerStats());
+
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    const Clock::time_point start = Clock::now();
+
+    auto worker = [&](int self) {
+        WorkerStats& stats = workerStats[self];
+        Clock::duration busy = Clock::duration::zero();
+        Range chunk;
+
+        if (pin) {
+            const CpuTopology& topology = CpuTopology::instance();
+            const size_t slot = static_cast<size_t>(firstCpu + self) % topology.cpus.size();
+            if (CpuTopology::pinCurrentThread(topology.cpus[slot])) {
+                stats.cpu = topology.cpus[slot];
+                stats.node = topology.nodes[slot];
+            }
+        }
+        if (init) {
+            try {
+                init(self);
+            } catch (...) {
+                // Leave the work of this worker to the others; the error is rethrown at the end
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) error = std::current_exception();
+                return;
+            }
+        }
+
+        for (;;) {
+            if (!queues[self].pop(chunk)) {
+                // Work is never created, only moved: if no deque has any, the loop is
+                // done (ranges in flight belong to workers that are still running)
+                bool found = false;
+                for (int k = 1; k < numWorkers && !found; k++) {
+                    found = queues[(self + k) % numWorkers].steal(chunk);
+                }
+                if (!found) break;
+                stats.steals++;
+                queues[self].push(chunk);
+                continue;
+            }
+
+            const Clock::time_point t0 = Clock::now();
+            try {
+                body(self, chunk.begin, chunk.end);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) error = std::current_exception();
+            }
+            busy += Clock::now() - t0;
+            stats.items += chunk.end - chunk.begin;
+            stats.chunks++;
+        }
+
+        stats.busySeconds = seconds(busy);
+    };
+
+    // A pinned calling thread would stay pinned after the loop
+    std::vector<std::thread> pool;
+    for (int w = pin ? 0 : 1; w < numWorkers; w++) {
+        pool.emplace_back(worker, w);
+    }
+    if (!pin) worker(0);
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+
+    // Idle time counts up to the end of the whole loop, not of each worker
+    const double wall = seconds(Clock::now() - start);
+    for (WorkerStats& stats : workerStats) {
+        stats.idleSeconds = wall - stats.busySeconds;
+    }
+
+    if (error) std::rethrow_exception(error);
+}
@@ -0,0 +1,215 @@
+#include "sharding.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SHARDING_HAVE_FORK 1
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#ifdef SHARDING_HAVE_FORK
+
+namespace {
+
+const int kMaxCandidates = 3 * kRepresentativesPerOutcome;
+
+// Tally of one (material, replica) pair of one worker process, as stored in the
+// shared segment: plain data, written by the worker and read by the coordinator
+struct SharedTally {
+    std::int64_t counts[3];
+    std::int32_t numCandidates;
+    std::int32_t outcomes[kMaxCandidates];
+    std::uint64_t histories[kMaxCandidates];
+};
+
+// Header of the segment area of one worker process
+struct SharedShard {
+    std::int32_t done;
+    WorkerStats stats;
+};
+
+// Anonymous shared mapping, inherited by the forked workers
+class SharedSegment {
+public:
+    SharedSegment(int shards, int slots)
+        : slots(slots), shardCount(shards),
+          size(shards * sizeof(SharedShard) + static_cast<size_t>(shards) * slots * sizeof(SharedTally)) {
+        memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANON, -1, 0);
+        if (memory == MAP_FAILED) {
+            throw std::runtime_error("Could not map the shared-memory segment of the worker processes");
+        }
+    }
+
+    ~SharedSegment() { munmap(memory, size); }
+
+    SharedShard& shard(int s) { return static_cast<SharedShard*>(memory)[s]; }
+
+    SharedTally& tally(int s, int slot) {
+        SharedTally* tallies = reinterpret_cast<SharedTally*>(static_cast<SharedShard*>(memory) + shardCount);
+        return tallies[static_cast<size_t>(s) * slots + slot];
+    }
+
+private:
+    int slots;
+    int shardCount;
+    size_t size;
+    void* memory;
+};
+
+// Body of a worker process: runs its range and publishes the tallies
+void runShard(const TransportSettings& settings, const std::vector<const BaseMaterial*>& materials,
+              const std::vector<WorkTask>& tasks, SharedSegment& segment, int s) {
+    // Pinned processes take consecutive CPUs of the pinning order
+    TransportSettings shardSettings = settings;
+    shardSettings.firstCpu = settings.firstCpu + s * settings.threads;
+    shardSettings.trajectoryFile = settings.outputDir + "/trajectories_" + std::to_string(s) + ".txt";
+
+    std::vector<WorkerStats> threadStats;
+    BatchTallies tallies = transportBatch(shardSettings, materials, tasks, threadStats);
+
+    const int slots = static_cast<int>(materials.size()) * settings.replicas;
+    for (int slot = 0; slot < slots; slot++) {
+        SharedTally& shared = segment.tally(s, slot);
+        std::memset(&shared, 0, sizeof(shared));
+        ReplicaTally total = mergeTallies(tallies, slot);
+        shared.counts[0] = total.NumAbsorbed;
+        shared.counts[1] = total.NumReflected;
+        shared.counts[2] = total.NumScaped;
+
+        // The first histories of each outcome are all the coordinator can keep
+        for (const HistoryRecord& record : total.representatives) {
+            shared.outcomes[shared.numCandidates] = static_cast<std::int32_t>(record.outcome);
+            shared.histories[shared.numCandidates] = record.history;
+            shared.numCandidates++;
+        }
+    }
+
+    WorkerStats& stats = segment.shard(s).stats;
+    stats = WorkerStats();
+    stats.cpu = threadStats.front().cpu;
+    stats.node = threadStats.front().node;
+    for (const WorkerStats& thread : threadStats) {
+        if (thread.node != stats.node) stats.node = -1;
+        stats.busySeconds += thread.busySeconds;
+        stats.idleSeconds += thread.idleSeconds;
+        stats.items += thread.items;
+        stats.chunks += thread.chunks;
+        stats.steals += thread.steals;
+    }
+    stats.busySeconds /= threadStats.size();
+    stats.idleSeconds /= threadStats.size();
+    segment.shard(s).done = 1;
+}
+
+pid_t forkShard(const TransportSettings& settings, const std::vector<const BaseMaterial*>& materials,
+                const std::vector<WorkTask>& tasks, SharedSegment& segment, int s) {
+    // Buffered output would otherwise be written once by every process
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        throw std::runtime_error("Could not fork worker process " + std::to_string(s));
+    }
+    if (pid == 0) {
+        int status = 0;
+        try {
+            runShard(settings, materials, tasks, segment, s);
+        } catch (const std::exception& e) {
+            std::cerr << "Worker process " << s << ": " << e.what() << std::endl;
+            status = 1;
+        }
+        // Skip the destructors and atexit handlers of the coordinator's objects
+        _exit(status);
+    }
+    return pid;
+}
+
+// Waits for a worker and tells whether it published its tallies
+bool joinShard(pid_t pid, SharedSegment& segment, int s) {
+    int status = 0;
+    pid_t waited;
+    while ((waited = waitpid(pid, &status, 0)) < 0 && errno == EINTR) {}
+    return waited == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0 && segment.shard(s).done == 1;
+}
+
+}
+
+std::vector<TransportResult> runTransportSharded(const TransportSettings& settings,
+                                                 const std::vector<const BaseMaterial*>& materials) {
+    const std::int64_t histories = batchHistories(settings, materials.size());
+    const int shards = static_cast<int>(std::max<std::int64_t>(1, std::min<std::int64_t>(settings.processes, histories)));
+    const int slots = static_cast<int>(materials.size()) * settings.replicas;
+    SharedSegment segment(shards, slots);
+
+    // Contiguous shares of equal estimated cost, one per process
+    std::vector<std::vector<WorkTask>> shares =
+        WorkStealingScheduler::partition(planBatch(settings, materials, shards * settings.threads), shards);
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<pid_t> pids(shards);
+    for (int s = 0; s < shards; s++) {
+        pids[s] = forkShard(settings, materials, shares[s], segment, s);
+    }
+
+    std::vector<int> failed;
+    for (int s = 0; s < shards; s++) {
+        if (!joinShard(pids[s], segment, s)) failed.push_back(s);
+    }
+
+    // Histories are reproducible, so a crashed share can simply be run again
+    for (int s : failed) {
+        const std::string range = shares[s].empty() ? std::string("none") :
+            "[" + std::to_string(shares[s].front().begin) + ", " + std::to_string(shares[s].back().end) + ")";
+        std::cerr << "Warning: worker process " << s << " failed, running histories " << range << " again" << std::endl;
+        segment.shard(s).done = 0;
+        if (!joinShard(forkShard(settings, materials, shares[s], segment, s), segment, s)) {
+            throw std::runtime_error("Worker process " + std::to_string(s) + " failed twice on histories " + range);
+        }
+    }
+
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // One tally row per process, merged like the rows of the threads (see mergeTallies)
+    BatchTallies tallies(shards, TallyRow(slots));
+    std::vector<WorkerStats> stats;
+    for (int s = 0; s < shards; s++) {
+        const std::uint32_t replicas = static_cast<std::uint32_t>(settings.replicas);
+        for (int slot = 0; slot < slots; slot++) {
+            const SharedTally& shared = segment.tally(s, slot);
+            ReplicaTally& tally = tallies[s][slot];
+            tally.NumAbsorbed = shared.counts[0];
+            tally.NumReflected = shared.counts[1];
+            tally.NumScaped = shared.counts[2];
+            for (int c = 0; c < shared.numCandidates; c++) {
+                tally.representatives.push_back({static_cast<HistoryOutcome>(shared.outcomes[c]),
+                                                 static_cast<std::uint32_t>(slot) % replicas, shared.histories[c]});
+            }
+        }
+        stats.push_back(segment.shard(s).stats);
+    }
+
+    std::vector<TransportResult> results = reduceBatch(settings, materials.size(), tallies);
+    for (TransportResult& result : results) {
+        result.workerStats = stats;
+        result.wallSeconds = wall;
+    }
+    return results;
+}
+
+#else
+
+std::vector<TransportResult> runTransportSharded(const TransportSettings&, const std::vector<const BaseMaterial*>&) {
+    throw std::runtime_error("Worker processes (--workers) need fork(), which this platform does not provide");
+}
+
+#endif
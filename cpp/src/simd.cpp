@@ -0,0 +1,37 @@
+#include "simd.hpp"
+
+namespace {
+
+SimdLevel detectLevel() {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SimdLevel::Avx512;
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::Avx2;
+#endif
+    return SimdLevel::Scalar;
+}
+
+const SimdLevel kMaxLevel = detectLevel();
+SimdLevel currentLevel = kMaxLevel;
+
+}
+
+SimdLevel maxSimdLevel() {
+    return kMaxLevel;
+}
+
+SimdLevel simdLevel() {
+    return currentLevel;
+}
+
+void setSimdLevel(SimdLevel level) {
+    currentLevel = static_cast<int>(level) < static_cast<int>(kMaxLevel) ? level : kMaxLevel;
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::Avx512: return "avx512";
+        case SimdLevel::Avx2: return "avx2";
+        default: return "scalar";
+    }
+}
@@ -0,0 +1,97 @@
+#include "sobol.hpp"
+
+namespace {
+
+// Primitive polynomials and initial direction numbers of Joe & Kuo (new-joe-kuo-6.21201)
+// for dimensions 2 to 4; the first dimension is the van der Corput sequence.
+struct DirectionInit {
+    int degree;
+    std::uint32_t coefficients;
+    std::uint32_t m[3];
+};
+
+const DirectionInit kInit[ScrambledSobol::kDimensions - 1] = {
+    {1, 0, {1, 0, 0}},
+    {2, 1, {1, 3, 0}},
+    {3, 1, {1, 3, 1}}
+};
+
+struct DirectionNumbers {
+    std::uint32_t v[ScrambledSobol::kDimensions][32];
+
+    DirectionNumbers() {
+        for (int j = 0; j < 32; ++j) v[0][j] = 1u << (31 - j);
+
+        for (int d = 1; d < ScrambledSobol::kDimensions; ++d) {
+            const DirectionInit& init = kInit[d - 1];
+            const int s = init.degree;
+            for (int j = 0; j < s; ++j) v[d][j] = init.m[j] << (31 - j);
+            for (int j = s; j < 32; ++j) {
+                std::uint32_t value = v[d][j - s] ^ (v[d][j - s] >> s);
+                for (int k = 1; k < s; ++k) {
+                    if ((init.coefficients >> (s - 1 - k)) & 1u) value ^= v[d][j - k];
+                }
+                v[d][j] = value;
+            }
+        }
+    }
+};
+
+const DirectionNumbers& directionNumbers() {
+    static const DirectionNumbers numbers;
+    return numbers;
+}
+
+std::uint32_t reverseBits(std::uint32_t x) {
+    x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+    x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+    x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+    x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+    return (x >> 16) | (x << 16);
+}
+
+// Laine-Karras style permutation: each bit only depends on the bits below it
+std::uint32_t laineKarras(std::uint32_t x, std::uint32_t seed) {
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return x;
+}
+
+std::uint32_t nestedUniformScramble(std::uint32_t x, std::uint32_t seed) {
+    return reverseBits(laineKarras(reverseBits(x), seed));
+}
+
+std::uint64_t splitmix64(std::uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+}
+
+ScrambledSobol::ScrambledSobol(std::uint64_t seed, std::uint32_t scramble) {
+    directionNumbers();
+    std::uint64_t state = splitmix64(seed ^ splitmix64(scramble));
+    for (int d = 0; d < kDimensions; ++d) {
+        state = splitmix64(state);
+        scrambleSeeds[d] = static_cast<std::uint32_t>(state >> 32);
+    }
+}
+
+ScrambledSobol::Point ScrambledSobol::point(std::uint32_t index) const {
+    const DirectionNumbers& numbers = directionNumbers();
+    Point p;
+    for (int d = 0; d < kDimensions; ++d) {
+        std::uint32_t x = 0;
+        for (int j = 0; j < 32 && (index >> j); ++j) {
+            if ((index >> j) & 1u) x ^= numbers.v[d][j];
+        }
+        x = nestedUniformScramble(x, scrambleSeeds[d]);
+        p[d] = x * (1.0 / 4294967296.0);
+    }
+    return p;
+}
@@ -2,10 +2,6 @@
 #include "particle.hpp"
 
 bool Sphere::isWithinBounds(const  Particle& particle) const {
-    double x = particle.getPosition()[0];
-    double y = particle.getPosition()[1];
-    double z = particle.getPosition()[2];
-
-    double dist = pow( pow(x, 2) + pow(y, 2) + pow(z , 2), 0.5 );
-    return dist <= radius;
+    const std::array<double, 3> position = particle.getPosition();
+    return contains(position[0], position[1], position[2]);
 }
@@ -0,0 +1,23 @@
+#include "sweep.hpp"
+#include <cmath>
+
+std::vector<double> sweepScales(double minScale, double maxScale, int points) {
+    std::vector<double> scales;
+    for (int i = 0; i < points; i++) {
+        double L = minScale + (maxScale - minScale) * i / (points - 1);
+        scales.push_back(std::trunc(L * 100.0 + 1e-9) / 100.0);
+    }
+    return scales;
+}
+
+std::vector<SweepPoint> runSweep(const TransportSettings& settings, const std::vector<double>& scales,
+                                 const std::vector<const BaseMaterial*>& materials) {
+    // All points run together on the same workers
+    std::vector<TransportResult> results = runTransport(settings, materials);
+
+    std::vector<SweepPoint> points;
+    for (size_t i = 0; i < scales.size(); i++) {
+        points.push_back({scales[i], results[i]});
+    }
+    return points;
+}
@@ -0,0 +1,98 @@
+#include "topology.hpp"
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+// Parses a sysfs CPU list such as "0-3,8-11"
+std::vector<int> parseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (item.empty()) continue;
+        size_t dash = item.find('-');
+        int first = std::stoi(item.substr(0, dash));
+        int last = (dash == std::string::npos) ? first : std::stoi(item.substr(dash + 1));
+        for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+// Node of every CPU, from /sys/devices/system/node/node<N>/cpulist
+std::map<int, int> readNodes() {
+    std::map<int, int> nodeOf;
+    for (int node = 0; node < 256; node++) {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!file) continue;
+        std::string list;
+        std::getline(file, list);
+        for (int cpu : parseCpuList(list)) nodeOf[cpu] = node;
+    }
+    return nodeOf;
+}
+
+CpuTopology detect() {
+    std::vector<int> allowed;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) allowed.push_back(cpu);
+        }
+    }
+#endif
+    if (allowed.empty()) {
+        for (unsigned cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); cpu++) {
+            allowed.push_back(static_cast<int>(cpu));
+        }
+    }
+
+    // Group the allowed CPUs by node, then interleave the groups
+    std::map<int, int> nodeOf = readNodes();
+    std::map<int, std::vector<int>> byNode;
+    for (int cpu : allowed) {
+        std::map<int, int>::const_iterator it = nodeOf.find(cpu);
+        byNode[it == nodeOf.end() ? 0 : it->second].push_back(cpu);
+    }
+
+    CpuTopology topology;
+    for (size_t i = 0; topology.cpus.size() < allowed.size(); i++) {
+        for (const auto& node : byNode) {
+            if (i < node.second.size()) {
+                topology.cpus.push_back(node.second[i]);
+                topology.nodes.push_back(node.first);
+            }
+        }
+    }
+    return topology;
+}
+
+}
+
+const CpuTopology& CpuTopology::instance() {
+    static const CpuTopology topology = detect();
+    return topology;
+}
+
+bool CpuTopology::pinCurrentThread(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
@@ -0,0 +1,63 @@
+#include "trajectorywriter.hpp"
+#include <chrono>
+#include <stdexcept>
+
+TrajectoryWriter::TrajectoryWriter(const std::string& filename, std::size_t capacity)
+    : filename(filename), file(filename), queue(capacity), closing(false)
+{
+    if (!file) {
+        throw std::runtime_error("Could not create trajectory file '" + filename + "'");
+    }
+    file << "# history point replica history outcome exit_x exit_y exit_z exit_vx exit_vy exit_vz points\n";
+    writer = std::thread(&TrajectoryWriter::run, this);
+}
+
+TrajectoryWriter::~TrajectoryWriter() {
+    try {
+        close();
+    } catch (const std::runtime_error&) {
+    }
+}
+
+void TrajectoryWriter::push(TrajectoryRecord& record) {
+    while (!queue.tryPush(record)) {
+        std::this_thread::yield();
+    }
+}
+
+void TrajectoryWriter::close() {
+    if (!writer.joinable()) return;
+    closing.store(true, std::memory_order_release);
+    writer.join();
+    file.flush();
+    if (!file) {
+        throw std::runtime_error("Could not write trajectory file '" + filename + "'");
+    }
+}
+
+void TrajectoryWriter::run() {
+    TrajectoryRecord record;
+    for (;;) {
+        if (queue.tryPop(record)) {
+            write(record);
+            continue;
+        }
+        // Producers are done once closing is set: drain what is left and stop
+        if (closing.load(std::memory_order_acquire)) {
+            while (queue.tryPop(record)) write(record);
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
+void TrajectoryWriter::write(const TrajectoryRecord& record) {
+    file << "history " << record.point << " " << record.replica << " " << record.history << " "
+         << outcomeName(record.outcome) << " "
+         << record.exitPosition[0] << " " << record.exitPosition[1] << " " << record.exitPosition[2] << " "
+         << record.exitVelocity[0] << " " << record.exitVelocity[1] << " " << record.exitVelocity[2] << " "
+         << record.trajectory.size() << "\n";
+    for (const auto& pos : record.trajectory) {
+        file << pos[0] << " " << pos[1] << " " << pos[2] << "\n";
+    }
+}
@@ -0,0 +1,509 @@
+#include "transport.hpp"
+#include "neutron.hpp"
+#include "chargedparticle.hpp"
+#include "regularslab.hpp"
+#include "doubleslab.hpp"
+#include "eventtransport.hpp"
+#include "rngengines.hpp"
+#include "sobol.hpp"
+#include "scheduler.hpp"
+#include "sharding.hpp"
+#include "trajectorywriter.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+// x-position of the entry face, used to tell reflected from transmitted particles.
+// Only slab geometries have one.
+bool getEntryPlane(const BaseMaterial& material, const std::string& shape, double& xinit) {
+    if (shape == "regular_slab") {
+        if (const RegularSlab* slabPtr = dynamic_cast<const RegularSlab*>(&material)) {
+            xinit = slabPtr->getXInit();
+            return true;
+        }
+    } else if (shape == "double_slab") {
+        if (const DoubleSlab* slabPtr = dynamic_cast<const DoubleSlab*>(&material)) {
+            xinit = slabPtr->getXInit();
+            return true;
+        }
+    }
+    return false;
+}
+
+// Transports the histories [begin, end) of a replica. The first histories of the
+// replica are handed to the writer, if any.
+void transportRange(const TransportSettings& settings, const BaseMaterial& material, int point,
+                    int run, std::int64_t begin, std::int64_t end, RandomGenerator& rng, ReplicaTally& tally,
+                    TrajectoryWriter* writer) {
+    ScrambledSobol sobol(settings.seed, run);
+    int kept[3] = {0, 0, 0};
+
+    for (std::int64_t i = begin; i < end; i++) {
+        // Every history draws from its own (seed, replica, history) stream
+        rng.setStream(run, i);
+        if (settings.rqmc) {
+            // Sobol points repeat after 2^32 histories of a replica
+            rng.setLeadingSamples(sobol.point(static_cast<std::uint32_t>(i)));
+        }
+
+        std::unique_ptr<Particle> particle = createParticle(settings);
+        const bool record = writer && i < settings.recordHistories;
+        particle->setRecordHistory(record);
+        HistoryOutcome outcome = transportHistory(*particle, material, settings, rng);
+
+        if (record) {
+            TrajectoryRecord data;
+            data.point = static_cast<std::uint32_t>(point);
+            data.replica = static_cast<std::uint32_t>(run);
+            data.history = static_cast<std::uint64_t>(i);
+            data.outcome = outcome;
+            data.exitPosition = particle->getPosition();
+            data.exitVelocity = particle->getVelocity();
+            data.trajectory = particle->takeHistory();
+            writer->push(data);
+        }
+
+        // Record final state of the particle
+        if (outcome == HistoryOutcome::Absorbed) tally.NumAbsorbed++;
+        else if (outcome == HistoryOutcome::Reflected) tally.NumReflected++;
+        else tally.NumScaped++;
+
+        // Keep the coordinates of the first histories of each outcome for replay
+        int& count = kept[static_cast<int>(outcome)];
+        if (count < kRepresentativesPerOutcome) {
+            tally.representatives.push_back({outcome, static_cast<std::uint32_t>(run), static_cast<std::uint64_t>(i)});
+            count++;
+        }
+    }
+}
+
+// Adds the counts and replay candidates of one tally to another
+void addTally(ReplicaTally& into, const ReplicaTally& from) {
+    into.NumAbsorbed += from.NumAbsorbed;
+    into.NumReflected += from.NumReflected;
+    into.NumScaped += from.NumScaped;
+    into.representatives.insert(into.representatives.end(), from.representatives.begin(), from.representatives.end());
+}
+
+// Merges the tallies of all workers replica by replica (see mergeTallies). Replica
+// candidates come sorted by history, so the kept ones are the first histories of each
+// outcome whichever worker ran them.
+TransportResult reduceTallies(const TransportSettings& settings, const BatchTallies& tallies) {
+    TransportResult result;
+    int kept[3] = {0, 0, 0};
+
+    for (int run = 0; run < settings.replicas; run++) {
+        ReplicaTally total = mergeTallies(tallies, run);
+        for (const HistoryRecord& record : total.representatives) {
+            int& count = kept[static_cast<int>(record.outcome)];
+            if (count < kRepresentativesPerOutcome) {
+                result.representatives.push_back(record);
+                count++;
+            }
+        }
+
+        // Store results from this run
+        result.absorbedRatios.push_back(static_cast<double>(total.NumAbsorbed) / settings.numberSims);
+        result.reflectedRatios.push_back(static_cast<double>(total.NumReflected) / settings.numberSims);
+        result.scapedRatios.push_back(static_cast<double>(total.NumScaped) / settings.numberSims);
+    }
+
+    return result;
+}
+
+}
+
+const char* outcomeName(HistoryOutcome outcome) {
+    switch (outcome) {
+        case HistoryOutcome::Absorbed: return "absorbed";
+        case HistoryOutcome::Reflected: return "reflected";
+        default: return "scaped";
+    }
+}
+
+TransportSettings TransportSettings::fromConfig(const json& config) {
+    TransportSettings settings;
+
+    settings.particleType = config["particle"]["type"];
+    settings.position = {{config["particle"]["x"], config["particle"]["y"], config["particle"]["z"]}};
+    settings.velocity = {{config["particle"]["vx"], config["particle"]["vy"], config["particle"]["vz"]}};
+
+    // Charge and mass are only relevant for charged particles
+    if (settings.particleType == "charged") {
+        settings.charge = config["particle"]["charge"];
+        settings.mass = config["particle"]["mass"];
+    }
+
+    settings.shape = config["geometry"]["shape"];
+    settings.numberSims = config["run"]["simulations"].get<std::int64_t>();
+    settings.saveHistories = config["run"].contains("save_hist");
+    settings.outputDir = "../out/" + config["run"]["run_name"].get<std::string>() + "/data";
+
+    // Optional run seed: fixing it makes the results reproducible
+    settings.seed = RandomGenerator::randomSeed();
+    if (config["run"].contains("seed") && !config["run"]["seed"].is_null()) {
+        settings.seed = config["run"]["seed"].get<std::uint64_t>();
+    }
+
+    // Number of statistical replicas; the standard deviations are computed across them
+    if (config["run"].contains("replicas") && !config["run"]["replicas"].is_null()) {
+        settings.replicas = config["run"]["replicas"];
+    }
+
+    // Optional in-run recording of the trajectories of the first histories of each replica
+    if (config["run"].contains("record_histories") && !config["run"]["record_histories"].is_null()) {
+        settings.recordHistories = config["run"]["record_histories"];
+    }
+    settings.trajectoryFile = settings.outputDir + "/trajectories.txt";
+
+    // Particles in flight per thread in the event-based loop
+    if (config["run"].contains("bank_size") && !config["run"]["bank_size"].is_null()) {
+        settings.bankSize = config["run"]["bank_size"];
+    }
+
+    // Sampler: plain Monte Carlo, or randomized quasi-Monte Carlo where each replica is
+    // an independent scramble of a Sobol sequence driving the first samples of every history
+    if (config["run"].contains("sampler") && !config["run"]["sampler"].is_null()) {
+        settings.rqmc = (config["run"]["sampler"] == "rqmc");
+    }
+
+    return settings;
+}
+
+std::unique_ptr<Particle> createParticle(const TransportSettings& settings) {
+    const std::array<double, 3>& r = settings.position;
+    const std::array<double, 3>& v = settings.velocity;
+    if (settings.particleType == "neutron") {
+        return std::make_unique<Neutron>(r[0], r[1], r[2], v[0], v[1], v[2]);
+    } else if (settings.particleType == "charged") {
+        return std::make_unique<ChargedParticle>(r[0], r[1], r[2], v[0], v[1], v[2], settings.charge, settings.mass);
+    }
+    throw std::runtime_error("Unknown particle type '" + settings.particleType + "'");
+}
+
+HistoryOutcome transportHistory(Particle& particle, const BaseMaterial& material,
+                                const TransportSettings& settings, RandomGenerator& rng) {
+    std::int64_t steps = 0;
+    return transportHistory(particle, material, settings, rng, steps);
+}
+
+HistoryOutcome transportHistory(Particle& particle, const BaseMaterial& material,
+                                const TransportSettings& settings, RandomGenerator& rng, std::int64_t& steps) {
+    // First propagation before checking absorption
+    particle.appendHistory();
+
+    particle.propagate(material, rng);
+    steps++;
+
+    // Particle loop: propagate until out of bounds or absorbed
+    while (material.isWithinBounds(particle)) {
+        if (particle.getAbsorption(material, rng)) {
+            return HistoryOutcome::Absorbed;
+        }
+        particle.propagate(material, rng);
+        steps++;
+    }
+
+    // Check if the particle was reflected (escaped through the entry side)
+    double xinit = 0.0;
+    if (getEntryPlane(material, settings.shape, xinit) && particle.getPosition()[0] < xinit) {
+        return HistoryOutcome::Reflected;
+    }
+    return HistoryOutcome::Scaped;
+}
+
+std::int64_t batchHistories(const TransportSettings& settings, size_t materials) {
+    return static_cast<std::int64_t>(settings.numberSims) * settings.replicas * static_cast<std::int64_t>(materials);
+}
+
+std::vector<double> pilotHistoryCosts(const TransportSettings& settings,
+                                      const std::vector<const BaseMaterial*>& materials, int histories) {
+    // A replica index no run reaches
+    const std::uint32_t kPilotReplica = 0xFFFFFFFFu;
+
+    std::unique_ptr<RandomGenerator> rng = createRandomGenerator(settings.rngEngine, settings.seed);
+    const std::int64_t n = std::max<std::int64_t>(1, std::min<std::int64_t>(histories, settings.numberSims));
+    std::vector<double> costs;
+    for (const BaseMaterial* material : materials) {
+        std::int64_t steps = 0;
+        for (std::int64_t i = 0; i < n; i++) {
+            rng->setStream(kPilotReplica, static_cast<std::uint64_t>(i));
+            std::unique_ptr<Particle> particle = createParticle(settings);
+            transportHistory(*particle, *material, settings, *rng, steps);
+        }
+        costs.push_back(1.0 + static_cast<double>(steps) / n);
+    }
+    return costs;
+}
+
+std::vector<WorkTask> planBatch(const TransportSettings& settings, const std::vector<double>& costs, int workers) {
+    const std::int64_t perMaterial = batchHistories(settings, 1);
+    double total = 0.0;
+    for (double cost : costs) total += cost * perMaterial;
+
+    // About eight tasks per worker, and sixteen chunks per task
+    const double target = total / (8.0 * std::max(1, workers));
+    std::vector<WorkTask> tasks;
+    auto add = [&](WorkTask task) {
+        const double perHistory = task.cost / (task.end - task.begin);
+        task.grain = std::max<std::int64_t>(1, std::min<std::int64_t>(1024, static_cast<std::int64_t>(target / 16.0 / perHistory)));
+        tasks.push_back(task);
+    };
+
+    WorkTask merged = {0, 0, 1, 0.0};
+    for (size_t m = 0; m < costs.size(); m++) {
+        const std::int64_t begin = static_cast<std::int64_t>(m) * perMaterial;
+        const double cost = costs[m] * perMaterial;
+
+        if (cost >= target) {
+            if (merged.end > merged.begin) add(merged);
+            merged = {0, 0, 1, 0.0};
+
+            const std::int64_t parts = std::min<std::int64_t>(perMaterial, static_cast<std::int64_t>(std::ceil(cost / target)));
+            for (std::int64_t p = 0; p < parts; p++) {
+                add({begin + perMaterial * p / parts, begin + perMaterial * (p + 1) / parts, 1, cost / parts});
+            }
+        } else {
+            // Cheap neighbours share a task until it reaches the target cost
+            if (merged.end == merged.begin) merged = {begin, begin, 1, 0.0};
+            merged.end = begin + perMaterial;
+            merged.cost += cost;
+            if (merged.cost >= target) {
+                add(merged);
+                merged = {0, 0, 1, 0.0};
+            }
+        }
+    }
+    if (merged.end > merged.begin) add(merged);
+    return tasks;
+}
+
+std::vector<WorkTask> planBatch(const TransportSettings& settings, const std::vector<const BaseMaterial*>& materials,
+                                int workers) {
+    std::vector<double> costs(materials.size(), 1.0);
+    if (materials.size() > 1) {
+        costs = pilotHistoryCosts(settings, materials);
+    }
+    return planBatch(settings, costs, workers);
+}
+
+template <typename Engine>
+BatchTallies transportBatch(const TransportSettings& settings, const std::vector<const BaseMaterial*>& materials,
+                            const std::vector<WorkTask>& tasks, std::vector<WorkerStats>& stats) {
+    WorkStealingScheduler scheduler(settings.threads, settings.pinThreads, settings.firstCpu);
+    const int workers = scheduler.workers();
+    const int runs = static_cast<int>(materials.size()) * settings.replicas;
+
+    // Per-worker generators and per-(material, replica) tallies: workers never write to
+    // shared state. Both are allocated by their worker (first touch on its NUMA node).
+    std::vector<std::unique_ptr<RandomGenerator>> generators(workers);
+    std::vector<std::unique_ptr<EventTransport>> banks(workers);
+    BatchTallies tallies(workers);
+    const bool eventBased = (settings.transport == "event");
+    auto init = [&](int worker) {
+        generators[worker] = std::make_unique<BasicRandomGenerator<Engine>>(settings.seed);
+        tallies[worker].resize(runs);
+        if (eventBased) {
+            std::vector<std::unique_ptr<RandomGenerator>> lanes;
+            for (int lane = 0; lane < settings.bankSize; lane++) {
+                lanes.push_back(std::make_unique<BasicRandomGenerator<Engine>>(settings.seed));
+            }
+            banks[worker] = std::make_unique<EventTransport>(settings, std::move(lanes));
+        }
+    };
+
+    // Recorded histories go to disk from a separate thread
+    std::unique_ptr<TrajectoryWriter> writer;
+    if (settings.recordHistories > 0) {
+        writer = std::make_unique<TrajectoryWriter>(settings.trajectoryFile);
+    }
+
+    // One index per history of every replica of every material, so the whole batch is
+    // balanced at once: workers done with a small geometry steal from the larger ones
+    scheduler.parallelFor(tasks,
+        [&](int worker, std::int64_t index, std::int64_t last) {
+            while (index < last) {
+                const int slot = static_cast<int>(index / settings.numberSims);
+                const std::int64_t first = index % settings.numberSims;
+                const std::int64_t stop = std::min(last - slot * settings.numberSims, settings.numberSims);
+                const BaseMaterial& material = *materials[slot / settings.replicas];
+                const int run = slot % settings.replicas;
+
+                // Recorded histories need a Particle, so they always take the analog path
+                const std::int64_t analogEnd = !eventBased ? stop :
+                    std::max(first, std::min<std::int64_t>(stop, writer ? settings.recordHistories : 0));
+                if (analogEnd > first) {
+                    transportRange(settings, material, slot / settings.replicas, run, first, analogEnd,
+                                   *generators[worker], tallies[worker][slot], writer.get());
+                }
+                if (stop > analogEnd) {
+                    banks[worker]->transport(material, run, analogEnd, stop, tallies[worker][slot]);
+                }
+                index += stop - first;
+            }
+        }, init);
+
+    if (writer) writer->close();
+    stats = scheduler.stats();
+    return tallies;
+}
+
+BatchTallies transportBatch(const TransportSettings& settings, const std::vector<const BaseMaterial*>& materials,
+                            const std::vector<WorkTask>& tasks, std::vector<WorkerStats>& stats) {
+    if (settings.rngEngine == PhiloxEngine::name()) {
+        return transportBatch<PhiloxEngine>(settings, materials, tasks, stats);
+    } else if (settings.rngEngine == Xoshiro256ppEngine::name()) {
+        return transportBatch<Xoshiro256ppEngine>(settings, materials, tasks, stats);
+    } else if (settings.rngEngine == Pcg64Engine::name()) {
+        return transportBatch<Pcg64Engine>(settings, materials, tasks, stats);
+    } else if (settings.rngEngine == Mt19937_64Engine::name()) {
+        return transportBatch<Mt19937_64Engine>(settings, materials, tasks, stats);
+    }
+    throw std::invalid_argument("Unknown random engine '" + settings.rngEngine + "'");
+}
+
+ReplicaTally mergeTallies(const BatchTallies& tallies, int slot) {
+    TallyRow level;
+    for (const TallyRow& row : tallies) level.push_back(row[slot]);
+    if (level.empty()) return ReplicaTally();
+
+    // Pairwise levels: (0+1, 2+3, ...), then (01+23, ...), until one tally is left
+    for (size_t stride = 1; stride < level.size(); stride *= 2) {
+        for (size_t w = 0; w + stride < level.size(); w += 2 * stride) {
+            addTally(level[w], level[w + stride]);
+        }
+    }
+
+    ReplicaTally total = std::move(level[0]);
+    std::vector<HistoryRecord> candidates;
+    candidates.swap(total.representatives);
+    std::sort(candidates.begin(), candidates.end(),
+              [](const HistoryRecord& a, const HistoryRecord& b) { return a.history < b.history; });
+    int kept[3] = {0, 0, 0};
+    for (const HistoryRecord& record : candidates) {
+        int& count = kept[static_cast<int>(record.outcome)];
+        if (count < kRepresentativesPerOutcome) {
+            total.representatives.push_back(record);
+            count++;
+        }
+    }
+    return total;
+}
+
+std::vector<TransportResult> reduceBatch(const TransportSettings& settings, size_t materials,
+                                         const BatchTallies& tallies) {
+    std::vector<TransportResult> results;
+    for (size_t m = 0; m < materials; m++) {
+        BatchTallies slice(tallies.size());
+        for (size_t w = 0; w < tallies.size(); w++) {
+            slice[w].assign(tallies[w].begin() + m * settings.replicas, tallies[w].begin() + (m + 1) * settings.replicas);
+        }
+        results.push_back(reduceTallies(settings, slice));
+    }
+    return results;
+}
+
+template <typename Engine>
+std::vector<TransportResult> runTransport(const TransportSettings& settings,
+                                          const std::vector<const BaseMaterial*>& materials) {
+    std::vector<WorkerStats> stats;
+    std::vector<WorkTask> tasks = planBatch(settings, materials, settings.threads);
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    BatchTallies tallies = transportBatch<Engine>(settings, materials, tasks, stats);
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<TransportResult> results = reduceBatch(settings, materials.size(), tallies);
+    for (TransportResult& result : results) {
+        result.workerStats = stats;
+        result.wallSeconds = wall;
+    }
+    return results;
+}
+
+template <typename Engine>
+TransportResult runTransport(const TransportSettings& settings, const BaseMaterial& material) {
+    return runTransport<Engine>(settings, std::vector<const BaseMaterial*>{&material}).front();
+}
+
+template TransportResult runTransport<PhiloxEngine>(const TransportSettings&, const BaseMaterial&);
+template TransportResult runTransport<Xoshiro256ppEngine>(const TransportSettings&, const BaseMaterial&);
+template TransportResult runTransport<Pcg64Engine>(const TransportSettings&, const BaseMaterial&);
+template TransportResult runTransport<Mt19937_64Engine>(const TransportSettings&, const BaseMaterial&);
+
+std::vector<TransportResult> runTransport(const TransportSettings& settings,
+                                          const std::vector<const BaseMaterial*>& materials) {
+    if (settings.processes > 1) {
+        return runTransportSharded(settings, materials);
+    }
+
+    if (settings.rngEngine == PhiloxEngine::name()) {
+        return runTransport<PhiloxEngine>(settings, materials);
+    } else if (settings.rngEngine == Xoshiro256ppEngine::name()) {
+        return runTransport<Xoshiro256ppEngine>(settings, materials);
+    } else if (settings.rngEngine == Pcg64Engine::name()) {
+        return runTransport<Pcg64Engine>(settings, materials);
+    } else if (settings.rngEngine == Mt19937_64Engine::name()) {
+        return runTransport<Mt19937_64Engine>(settings, materials);
+    }
+    throw std::invalid_argument("Unknown random engine '" + settings.rngEngine + "'");
+}
+
+TransportResult runTransport(const TransportSettings& settings, const BaseMaterial& material) {
+    return runTransport(settings, std::vector<const BaseMaterial*>{&material}).front();
+}
+
+std::unique_ptr<RandomGenerator> createRandomGenerator(const std::string& engine, std::uint64_t seed) {
+    if (engine == PhiloxEngine::name()) {
+        return std::make_unique<BasicRandomGenerator<PhiloxEngine>>(seed);
+    } else if (engine == Xoshiro256ppEngine::name()) {
+        return std::make_unique<BasicRandomGenerator<Xoshiro256ppEngine>>(seed);
+    } else if (engine == Pcg64Engine::name()) {
+        return std::make_unique<BasicRandomGenerator<Pcg64Engine>>(seed);
+    } else if (engine == Mt19937_64Engine::name()) {
+        return std::make_unique<BasicRandomGenerator<Mt19937_64Engine>>(seed);
+    }
+    throw std::invalid_argument("Unknown random engine '" + engine + "'");
+}
+
+std::unique_ptr<Particle> replayHistory(const TransportSettings& settings, const BaseMaterial& material,
+                                        std::uint32_t replica, std::uint64_t history,
+                                        HistoryOutcome& outcome) {
+    std::unique_ptr<RandomGenerator> rng = createRandomGenerator(settings.rngEngine, settings.seed);
+
+    // Same stream, and same leading quasi-random point, as in the original run
+    rng->setStream(replica, history);
+    if (settings.rqmc) {
+        rng->setLeadingSamples(ScrambledSobol(settings.seed, replica).point(static_cast<std::uint32_t>(history)));
+    }
+
+    std::unique_ptr<Particle> particle = createParticle(settings);
+    particle->setRecordHistory(true);
+    outcome = transportHistory(*particle, material, settings, *rng);
+    return particle;
+}
+
+void saveRepresentativeHistories(const TransportSettings& settings, const BaseMaterial& material,
+                                 const TransportResult& result, double scale) {
+    bool saved[3] = {false, false, false};
+    std::ofstream index(settings.outputDir + "/replay_index.txt");
+    index << "# seed " << settings.seed << " engine " << settings.rngEngine
+          << " sampler " << (settings.rqmc ? "rqmc" : "mc") << " scale " << scale << "\n";
+    index << "# outcome id replica history\n";
+
+    for (const HistoryRecord& record : result.representatives) {
+        std::uint64_t id = record.replica * static_cast<std::uint64_t>(settings.numberSims) + record.history;
+        index << outcomeName(record.outcome) << " " << id << " " << record.replica << " " << record.history << "\n";
+
+        int k = static_cast<int>(record.outcome);
+        if (!saved[k]) {
+            HistoryOutcome outcome;
+            std::unique_ptr<Particle> particle = replayHistory(settings, material, record.replica, record.history, outcome);
+            particle->saveHistoryToFile(settings.outputDir + "/hist_" + outcomeName(outcome) + ".txt");
+            saved[k] = true;
+        }
+    }
+}
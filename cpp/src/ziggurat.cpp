@@ -0,0 +1,31 @@
+#include "ziggurat.hpp"
+
+constexpr double ExponentialZiggurat::kR;
+constexpr double ExponentialZiggurat::kV;
+
+const ExponentialZiggurat& ExponentialZiggurat::instance() {
+    static const ExponentialZiggurat ziggurat;
+    return ziggurat;
+}
+
+ExponentialZiggurat::ExponentialZiggurat() {
+    const double m = 9007199254740992.0;  // 2^53
+    double de = kR;
+    double te = kR;
+    const double q = kV / std::exp(-de);
+
+    k[0] = static_cast<std::uint64_t>((de / q) * m);
+    k[1] = 0;
+    w[0] = q / m;
+    w[255] = de / m;
+    f[0] = 1.0;
+    f[255] = std::exp(-de);
+
+    for (int i = 254; i >= 1; --i) {
+        de = -std::log(kV / de + std::exp(-de));
+        k[i + 1] = static_cast<std::uint64_t>((de / te) * m);
+        te = de;
+        f[i] = std::exp(-de);
+        w[i] = de / m;
+    }
+}